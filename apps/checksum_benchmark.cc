@@ -0,0 +1,114 @@
+#include "util.hh"
+
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+//! The checksum loop that InternetChecksum::add used to run: one byte per iteration, but with a 64-bit sum (the
+//! old 32-bit one overflows after about 128 kB of 0xff bytes), so that it is a reference for the others
+static uint16_t bytewise_checksum(const string_view data) {
+    uint64_t sum = 0;
+    bool parity = false;
+    for (size_t i = 0; i < data.size(); i++) {
+        uint16_t val = uint8_t(data[i]);
+        if (not parity) {
+            val <<= 8;
+        }
+        sum += val;
+        parity = !parity;
+    }
+    while (sum > 0xffff) {
+        sum = (sum >> 16) + (sum & 0xffff);
+    }
+    return ~sum;
+}
+
+static uint16_t word_checksum(const string_view data) {
+    InternetChecksum check;
+    check.add(data);
+    return check.value();
+}
+
+//! Copies `data` to `dst`, then checksums it
+static uint16_t copy_then_checksum(char *dst, const string_view data) {
+    memcpy(dst, data.data(), data.size());
+    InternetChecksum check;
+    check.add(data);
+    return check.value();
+}
+
+//! Copies `data` to `dst` and checksums it in one pass
+static uint16_t fused_copy_and_checksum(char *dst, const string_view data) {
+    InternetChecksum check;
+    check.copy_and_add(dst, data);
+    return check.value();
+}
+
+//! Takes every result that measure() computes, so that its loop is not optimized away
+static volatile uint16_t checksum_sink = 0;
+
+//! Checksums `data` until about 1 GB has been summed, and returns the rate in GB/s
+template <typename Checksum>
+static double measure(const string &data, Checksum checksum) {
+    const size_t rounds = max<size_t>((1 << 30) / data.size(), 1);
+    const auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < rounds; i++) {
+        checksum_sink = checksum(data);
+    }
+    const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    return static_cast<double>(rounds * data.size()) / elapsed.count() / 1e9;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        cout << fixed << setprecision(2);
+        cout << setw(10) << "bytes" << setw(14) << "bytewise GB/s" << setw(14) << "add() GB/s" << setw(10) << "speedup"
+             << setw(16) << "memcpy+add GB/s" << setw(18) << "copy_and_add GB/s"
+             << "\n";
+
+        // A bare header, a full segment, a GSO super-segment and a large buffer
+        for (const size_t size : {20, 1452, 63888, 1 << 20}) {
+            string data(size, '\0');
+            for (char &c : data) {
+                c = static_cast<char>(rd());
+            }
+
+            // Copies go to a buffer as large as the data, as payloads are copied into new segments
+            string copy(size, '\0');
+            const auto copy_then_checksum_data = [&copy](const string_view d) {
+                return copy_then_checksum(copy.data(), d);
+            };
+            const auto fused_copy_and_checksum_data = [&copy](const string_view d) {
+                return fused_copy_and_checksum(copy.data(), d);
+            };
+
+            const uint16_t expected = bytewise_checksum(data);
+            if (word_checksum(data) != expected or copy_then_checksum_data(data) != expected or
+                fused_copy_and_checksum_data(data) != expected or copy != data) {
+                cerr << "The checksums of " << size << " bytes differ\n";
+                return EXIT_FAILURE;
+            }
+
+            const double bytewise = measure(data, bytewise_checksum);
+            const double word = measure(data, word_checksum);
+            const double copy_then = measure(data, copy_then_checksum_data);
+            const double fused = measure(data, fused_copy_and_checksum_data);
+            cout << setw(10) << size << setw(14) << bytewise << setw(14) << word << setw(9) << word / bytewise << "x"
+                 << setw(16) << copy_then << setw(18) << fused << "\n";
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -10,9 +10,21 @@ add_test(NAME t_wrapping_ints_roundtrip   COMMAND wrapping_integers_roundtrip)
 add_test(NAME t_recv_connect         COMMAND recv_connect)
 add_test(NAME t_recv_transmit        COMMAND recv_transmit)
 add_test(NAME t_recv_window          COMMAND recv_window)
+add_test(NAME t_recv_sws             COMMAND recv_sws)
 add_test(NAME t_recv_reorder         COMMAND recv_reorder)
 add_test(NAME t_recv_close           COMMAND recv_close)
 add_test(NAME t_recv_special         COMMAND recv_special)
+add_test(NAME t_recv_sack            COMMAND recv_sack)
+add_test(NAME t_recv_wscale          COMMAND recv_wscale)
+add_test(NAME t_recv_timestamps      COMMAND recv_timestamps)
+add_test(NAME t_recv_fastopen        COMMAND recv_fastopen)
+add_test(NAME t_recv_ecn             COMMAND recv_ecn)
+add_test(NAME t_recv_info            COMMAND recv_info)
+add_test(NAME t_recv_delack          COMMAND recv_delack)
+add_test(NAME t_recv_zero_copy       COMMAND recv_zero_copy)
+add_test(NAME t_recv_gro             COMMAND recv_gro)
+add_test(NAME t_recv_batch           COMMAND recv_batch)
+add_test(NAME t_recv_autotune        COMMAND recv_autotune)
 
 add_test(NAME t_send_connect         COMMAND send_connect)
 add_test(NAME t_send_transmit        COMMAND send_transmit)
@@ -21,6 +33,20 @@ add_test(NAME t_send_window          COMMAND send_window)
 add_test(NAME t_send_ack             COMMAND send_ack)
 add_test(NAME t_send_close           COMMAND send_close)
 add_test(NAME t_send_extra           COMMAND send_extra)
+add_test(NAME t_send_sack            COMMAND send_sack)
+add_test(NAME t_send_rack            COMMAND send_rack)
+add_test(NAME t_send_pacing          COMMAND send_pacing)
+add_test(NAME t_send_coalesce        COMMAND send_coalesce)
+add_test(NAME t_send_gso             COMMAND send_gso)
+add_test(NAME t_send_zero_copy       COMMAND send_zero_copy)
+add_test(NAME t_send_repacketize     COMMAND send_repacketize)
+add_test(NAME t_send_wscale          COMMAND send_wscale)
+add_test(NAME t_send_mss             COMMAND send_mss)
+add_test(NAME t_send_fastopen        COMMAND send_fastopen)
+add_test(NAME t_send_ecn             COMMAND send_ecn)
+add_test(NAME t_send_timestamps      COMMAND send_timestamps)
+add_test(NAME t_send_info            COMMAND send_info)
+add_test(NAME t_send_autotune        COMMAND send_autotune)
 
 add_test(NAME t_strm_reassem_single      COMMAND fsm_stream_reassembler_single)
 add_test(NAME t_strm_reassem_seq         COMMAND fsm_stream_reassembler_seq)
@@ -45,6 +71,8 @@ add_test(NAME router_test    COMMAND network_simulator)
 
 add_test(NAME t_tcp_parser           COMMAND tcp_parser "${PROJECT_SOURCE_DIR}/tests/ipv4_parser.data")
 add_test(NAME t_ipv4_parser          COMMAND ipv4_parser "${PROJECT_SOURCE_DIR}/tests/ipv4_parser.data")
+add_test(NAME t_internet_checksum    COMMAND internet_checksum)
+add_test(NAME t_tcp_options          COMMAND tcp_options)
 add_test(NAME t_active_close         COMMAND fsm_active_close)
 add_test(NAME t_passive_close        COMMAND fsm_passive_close)
 add_test(NAME ec_ack_rst             COMMAND fsm_ack_rst)
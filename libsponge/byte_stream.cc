@@ -1,31 +1,52 @@
 #include "byte_stream.hh"
 
-#include <vector>
+#include "util.hh"
+
+#include <algorithm>
+#include <utility>
 
 ByteStream::ByteStream(const size_t cap)
-    : capacity(cap), buffer(), read_idx(0), write_idx(0), _input_ended(false), _output_ended(false), _error(false) {
-    buffer.resize(cap);
+    : _capacity(cap), buffer(), read_idx(0), write_idx(0), _input_ended(false), _output_ended(false), _error(false) {}
+
+size_t ByteStream::write(const std::string &data) { return write(data.substr(0, remaining_capacity())); }
+
+size_t ByteStream::write(std::string &&data) {
+    if (data.size() > remaining_capacity())
+        data.resize(remaining_capacity());
+    const size_t cnt = data.size();
+    if (cnt == 0)
+        return 0;
+
+    if (cnt >= MERGE_WRITE_SIZE || buffer.empty() || !buffer.back().try_append(data))
+        buffer.emplace_back(std::move(data));
+    write_idx += cnt;
+    return cnt;
 }
 
-size_t ByteStream::write(const std::string &data) {
-    size_t cnt = 0;
-    for (; cnt < data.size() && remaining_capacity() > 0; write_idx++, cnt++)
-        buffer[write_idx % capacity] = data[cnt];
+size_t ByteStream::write(Buffer data) {
+    if (data.size() > remaining_capacity())
+        data.remove_suffix(data.size() - remaining_capacity());
+    const size_t cnt = data.size();
+    if (cnt == 0)
+        return 0;
+
+    if (cnt >= MERGE_WRITE_SIZE || buffer.empty() || !buffer.back().try_append(data))
+        buffer.push_back(std::move(data));
+    write_idx += cnt;
     return cnt;
 }
 
 //! \param[in] len bytes will be copied from the output side of the buffer
 std::string ByteStream::peek_output(const size_t len) const {
-    size_t i = read_idx;
-    size_t cnt = 0;
     std::string peek;
 
     // There isn't enough content to be copied.
     if (read_idx + len > write_idx)
         return peek;
 
-    for (; i < write_idx && cnt < len; i++, cnt++)
-        peek.push_back(buffer[i % capacity]);
+    peek.reserve(len);
+    for (auto it = buffer.begin(); peek.size() < len; it++)
+        peek.append((*it).str().substr(0, len - peek.size()));
     return peek;
 }
 
@@ -36,25 +57,69 @@ void ByteStream::pop_output(const size_t len) {
         return;
     }
     read_idx += len;
+
+    size_t remain = len;
+    while (remain > 0) {
+        const size_t chunk = std::min(remain, buffer.front().size());
+        buffer.front().remove_prefix(chunk);
+        remain -= chunk;
+        if (buffer.front().size() == 0)
+            buffer.pop_front();
+    }
 }
 
 //! Read (i.e., copy and then pop) the next "len" bytes of the stream
 //! \param[in] len bytes will be popped and returned
 //! \returns a string
 std::string ByteStream::read(const size_t len) {
-    size_t cnt = 0;
-    std::string str_read;
-
     // There isn't enough content to read.
     if (read_idx + len > write_idx) {
         _error = true;
-        return str_read;
+        return {};
     }
-    for (; read_idx < write_idx && cnt < len; read_idx++, cnt++)
-        str_read.push_back(buffer[read_idx % capacity]);
+
+    std::string str_read = peek_output(len);
+    pop_output(len);
     return str_read;
 }
 
+//! \param[in] len bytes will be popped and returned
+//! \returns a slice of the written chunk, or a new Buffer if the bytes span several writes
+Buffer ByteStream::read_buffer(const size_t len) {
+    // There isn't enough content to read.
+    if (read_idx + len > write_idx) {
+        _error = true;
+        return {};
+    }
+    if (len == 0)
+        return {};
+
+    if (buffer.front().size() < len)
+        return read(len);
+
+    Buffer slice = buffer.front();
+    slice.remove_suffix(slice.size() - len);
+    pop_output(len);
+    return slice;
+}
+
+//! \param[in] len bytes will be popped and returned
+Buffer ByteStream::read_buffer_and_checksum(const size_t len) {
+    if (read_idx + len > write_idx || len == 0 || buffer.front().size() >= len)
+        return read_buffer(len);
+
+    std::string bytes(len, '\0');
+    InternetChecksum check;
+    size_t copied = 0;
+    for (auto it = buffer.begin(); copied < len; it++) {
+        const std::string_view chunk = (*it).str().substr(0, len - copied);
+        check.copy_and_add(bytes.data() + copied, chunk);
+        copied += chunk.size();
+    }
+    pop_output(len);
+    return Buffer{std::move(bytes), check.partial()};
+}
+
 void ByteStream::end_input() {
     if (_input_ended) {
         _error = true;
@@ -75,4 +140,4 @@ size_t ByteStream::bytes_written() const { return write_idx; }
 
 size_t ByteStream::bytes_read() const { return read_idx; }
 
-size_t ByteStream::remaining_capacity() const { return capacity - (write_idx - read_idx); }
\ No newline at end of file
+size_t ByteStream::remaining_capacity() const { return _capacity - std::min(_capacity, write_idx - read_idx); }
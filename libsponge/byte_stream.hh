@@ -1,18 +1,27 @@
 #ifndef SPONGE_LIBSPONGE_BYTE_STREAM_HH
 #define SPONGE_LIBSPONGE_BYTE_STREAM_HH
 
+#include "buffer.hh"
+
+#include <deque>
 #include <string>
-#include <vector>
 
 //! \brief An in-order byte stream.
 
 //! Bytes are written on the "input" side and read from the "output"
 //! side.  The byte stream is finite: the writer can end the input,
-//! and then no more bytes can be written.
+//! and then no more bytes can be written. Each write is kept as a
+//! reference-counted chunk, so a reader can take bytes out as a Buffer
+//! that shares the writer's storage instead of copying them. Small
+//! writes are copied onto the end of the previous chunk instead.
 class ByteStream {
   private:
-    size_t capacity;
-    std::vector<int8_t> buffer;
+    //! Writes smaller than this are copied onto the end of the last chunk when no reader shares it, so that a
+    //! writer of many small pieces does not pay for a chunk and its reference count on each
+    static constexpr size_t MERGE_WRITE_SIZE = 256;
+
+    size_t _capacity;
+    std::deque<Buffer> buffer;
     size_t read_idx;
     size_t write_idx;
     bool _input_ended;
@@ -31,9 +40,23 @@ class ByteStream {
     //! \returns the number of bytes accepted into the stream
     size_t write(const std::string &data);
 
+    //! Write a string of bytes into the stream, taking ownership of its storage if it all fits.
+    //! \returns the number of bytes accepted into the stream
+    size_t write(std::string &&data);
+
+    //! Write a Buffer into the stream without copying it: the stream keeps a slice that shares its storage.
+    //! \returns the number of bytes accepted into the stream
+    size_t write(Buffer data);
+
     //! \returns the number of additional bytes that the stream has space for
     size_t remaining_capacity() const;
 
+    //! \returns the most bytes the stream holds at once
+    size_t capacity() const { return _capacity; }
+
+    //! Change the capacity. Bytes already buffered are kept even if they no longer fit; writes wait for room.
+    void set_capacity(const size_t capacity) { _capacity = capacity; }
+
     //! Signal that the byte stream has reached its ending
     void end_input();
 
@@ -55,6 +78,14 @@ class ByteStream {
     //! \returns a string
     std::string read(const size_t len);
 
+    //! Read the next "len" bytes of the stream without copying them when they come from a single write
+    //! \returns a Buffer that shares storage with the written data
+    Buffer read_buffer(const size_t len);
+
+    //! Read the next "len" bytes of the stream as read_buffer() does. When the bytes span several writes and so
+    //! are copied, their Buffer::partial_sum() is computed in the same pass.
+    Buffer read_buffer_and_checksum(const size_t len);
+
     //! \returns `true` if the stream input has ended
     bool input_ended() const;
 
@@ -1,5 +1,6 @@
 #include "stream_reassembler.hh"
 
+#include <algorithm>
 #include <iostream>
 
 StreamReassembler::StreamReassembler(const size_t capacity)
@@ -9,28 +10,34 @@ StreamReassembler::StreamReassembler(const size_t capacity)
 //! possibly out-of-order, from the logical stream, and assembles any newly
 //! contiguous substrings and writes them into the output stream in order.
 void StreamReassembler::push_substring(const std::string &data, const uint64_t index, const bool eof) {
+    push_substring(Buffer{std::string(data)}, index, eof);
+}
+
+void StreamReassembler::push_substring(const Buffer &data, const uint64_t index, const bool eof) {
     uint64_t start_idx = index;
     uint64_t end_idx = index + data.size();
-    std::string data_peeled = data;
+    Buffer data_peeled = data;
     decltype(_auxillary.begin()) target_insert = _auxillary.end();
     std::vector<decltype(_auxillary.begin())> target_replace;
     bool valid = true;
 
     // Invalid data: empty, has been assembled, no capacity.
-    if (data.size() == 0 || end_idx <= _index_assembled ||
-        _index_assembled + _output.remaining_capacity() - start_idx <= 0)
+    if (data.size() == 0 || end_idx <= _index_assembled || start_idx >= _index_assembled + _output.remaining_capacity())
         valid = false;
 
     // Part of the data has been assembled.
     if (valid && index < _index_assembled) {
         start_idx = _index_assembled;
-        data_peeled = data_peeled.substr(_index_assembled - index);
+        data_peeled.remove_prefix(_index_assembled - index);
     }
 
-    // Part of the data should be dropped because there isn't enough space to hold it in the buffer.
-    if (valid && end_idx > _index_assembled + _output.remaining_capacity()) {
-        data_peeled = data_peeled.substr(0, _index_assembled + _output.remaining_capacity() - start_idx);
-        end_idx = _index_assembled + _output.remaining_capacity();
+    // Part of the data (or all of it, if it starts beyond the window) should be dropped because there isn't enough
+    // space to hold it in the buffer.
+    if (end_idx > _index_assembled + _output.remaining_capacity()) {
+        if (valid) {
+            data_peeled.remove_suffix(end_idx - (_index_assembled + _output.remaining_capacity()));
+            end_idx = _index_assembled + _output.remaining_capacity();
+        }
     } else if (eof)
         _eof = true;
 
@@ -44,11 +51,11 @@ void StreamReassembler::push_substring(const std::string &data, const uint64_t i
 
         // Have intersections.
         if (start_idx <= (*it).end && (*it).start <= start_idx) {
-            data_peeled = data_peeled.substr((*it).end - start_idx);
+            data_peeled.remove_prefix((*it).end - start_idx);
             start_idx += (*it).end - start_idx;
         }
         if (end_idx > (*it).start && (*it).end >= end_idx) {
-            data_peeled = data_peeled.substr(0, data_peeled.size() - (end_idx - (*it).start));
+            data_peeled.remove_suffix(end_idx - (*it).start);
             end_idx -= (end_idx - (*it).start);
         }
 
@@ -61,17 +68,29 @@ void StreamReassembler::push_substring(const std::string &data, const uint64_t i
             target_replace.push_back(it);
     }
 
-    // If it's a valid data, insert it into the auxillary vector.
-    BytesInterval bi(start_idx, end_idx);
+    // If it's a valid data, insert it into the auxillary vector, unless it is next in order and can go straight
+    // to the byte stream.
     if (valid) {
-        bi.data = data_peeled;
-        _auxillary.insert(target_insert, bi);
-        _unassembled += data_peeled.size();
-
         for (auto it : target_replace) {
+            if (it == target_insert)
+                target_insert++;
             _unassembled -= (*it).data.size();
             _auxillary.erase(it);
         }
+
+        if (start_idx == _index_assembled) {
+            const size_t size = data_peeled.size();
+            if (size >= MIN_SHARED_SIZE && 4 * size >= data_peeled.storage_capacity())
+                _output.write(data_peeled);
+            else
+                _output.write(data_peeled.copy());
+            _index_assembled = end_idx;
+        } else {
+            BytesInterval bi(start_idx, end_idx);
+            bi.data = Buffer{data_peeled.copy()};
+            _auxillary.insert(target_insert, bi);
+            _unassembled += data_peeled.size();
+        }
     }
 
     // Stage the auxillary substrings to the byte stream.
@@ -88,6 +107,47 @@ void StreamReassembler::push_substring(const std::string &data, const uint64_t i
     }
 }
 
+void StreamReassembler::set_capacity(const size_t capacity) {
+    _capacity = capacity;
+    _output.set_capacity(capacity);
+
+    const uint64_t limit = _index_assembled + _output.remaining_capacity();
+    while (!_auxillary.empty() && _auxillary.back().end > limit) {
+        BytesInterval &last = _auxillary.back();
+        _eof = false;
+        if (last.start >= limit) {
+            _unassembled -= last.data.size();
+            _auxillary.pop_back();
+        } else {
+            _unassembled -= last.end - limit;
+            last.data.remove_suffix(last.end - limit);
+            last.end = limit;
+        }
+    }
+}
+
 size_t StreamReassembler::unassembled_bytes() const { return _unassembled; }
 
 bool StreamReassembler::empty() const { return _unassembled == 0; }
+
+std::vector<std::pair<uint64_t, uint64_t>> StreamReassembler::unassembled_ranges() const {
+    std::vector<std::pair<uint64_t, uint64_t>> ranges;
+    for (const auto &interval : _auxillary) {
+        if (!ranges.empty() && ranges.back().second >= interval.start)
+            ranges.back().second = std::max<uint64_t>(ranges.back().second, interval.end);
+        else
+            ranges.emplace_back(interval.start, interval.end);
+    }
+    return ranges;
+}
+
+size_t StreamReassembler::hole_count() const {
+    size_t holes = 0;
+    uint64_t end = 0;
+    for (const auto &interval : _auxillary) {
+        if (holes == 0 || end < interval.start)
+            holes++;
+        end = std::max<uint64_t>(end, interval.end);
+    }
+    return holes;
+}
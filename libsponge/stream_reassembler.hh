@@ -6,11 +6,13 @@
 #include <cstdint>
 #include <list>
 #include <string>
+#include <utility>
+#include <vector>
 
 struct BytesInterval {
     size_t start;
     size_t end;
-    std::string data;
+    Buffer data;
     BytesInterval(const size_t s, const size_t e) : start(s), end(e), data() {}
 };
 
@@ -18,6 +20,10 @@ struct BytesInterval {
 //! possibly overlapping) into an in-order byte stream.
 class StreamReassembler {
   private:
+    //! An in-order substring at least this long, and at least a quarter of the storage it shares, goes into the
+    //! stream as a slice; anything else is copied, so that a small slice does not keep a large allocation alive
+    static constexpr size_t MIN_SHARED_SIZE = 512;
+
     ByteStream _output;  //!< The reassembled in-order byte stream
     size_t _capacity;    //!< The maximum number of bytes
     std::list<BytesInterval> _auxillary;
@@ -41,6 +47,19 @@ class StreamReassembler {
     //! \param eof the last byte of `data` will be the last byte in the entire stream
     void push_substring(const std::string &data, const uint64_t index, const bool eof);
 
+    //! \brief Receive a substring held in a Buffer, copying it only when that saves memory
+    //!
+    //! The substring is trimmed to what is new and fits. If it is next in order, large, and uses much of its
+    //! storage, the stream keeps a slice that shares `data`'s storage. Otherwise its bytes are copied once, into
+    //! the stream or the out-of-order store, so that memory held stays close to what the capacity counts.
+    void push_substring(const Buffer &data, const uint64_t index, const bool eof);
+
+    //! \brief Change the capacity, for buffer autotuning
+    //!
+    //! Out-of-order bytes that no longer fit are discarded (and, if they held the end of the stream, the
+    //! end is forgotten); bytes already reassembled are kept.
+    void set_capacity(const size_t capacity);
+
     //! \name Access the reassembled byte stream
     //!@{
     const ByteStream &stream_out() const { return _output; }
@@ -58,6 +77,13 @@ class StreamReassembler {
     bool empty() const;
 
     uint64_t assembled_idx() const { return _index_assembled; }
+
+    //! \brief The [start, end) index ranges held but not yet assembled, in order, with adjacent ranges merged
+    std::vector<std::pair<uint64_t, uint64_t>> unassembled_ranges() const;
+
+    //! \brief The number of gaps before and between the unassembled ranges (the size of unassembled_ranges(),
+    //! counted without allocating)
+    size_t hole_count() const;
 };
 
 #endif  // SPONGE_LIBSPONGE_STREAM_REASSEMBLER_HH
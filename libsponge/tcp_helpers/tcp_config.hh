@@ -2,11 +2,16 @@
 #define SPONGE_LIBSPONGE_TCP_CONFIG_HH
 
 #include "address.hh"
+#include "tcp_header.hh"
+#include "tcp_memory.hh"
 #include "wrapping_integers.hh"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <optional>
+#include <string>
 
 //! Config for TCP sender and receiver
 class TCPConfig {
@@ -15,11 +20,50 @@ class TCPConfig {
     static constexpr size_t MAX_PAYLOAD_SIZE = 1452;   //!< Max TCP payload that fits in either IPv4 or UDP datagram
     static constexpr uint16_t TIMEOUT_DFLT = 1000;     //!< Default re-transmit timeout is 1 second
     static constexpr unsigned MAX_RETX_ATTEMPTS = 8;   //!< Maximum re-transmit attempts before giving up
+    static constexpr size_t MAX_GSO_PAYLOAD_SIZE = 44 * MAX_PAYLOAD_SIZE;  //!< Largest GSO super-segment (< 64 KB)
 
     uint16_t rt_timeout = TIMEOUT_DFLT;       //!< Initial value of the retransmission timeout, in milliseconds
     size_t recv_capacity = DEFAULT_CAPACITY;  //!< Receive capacity, in bytes
     size_t send_capacity = DEFAULT_CAPACITY;  //!< Sender capacity, in bytes
     std::optional<WrappingInt32> fixed_isn{};
+    bool sack = false;             //!< Offer SACK on our SYN, and use it if the peer agrees
+    bool rack_tlp = false;         //!< Detect losses with RACK and probe tail losses with TLP (RFC 8985)
+    bool pacing = false;           //!< Spread new segments out in time instead of sending the window in one burst
+    uint64_t pacing_rate_cap = 0;  //!< Highest pacing rate, in bytes per second (0 means no cap)
+    bool nagle = false;            //!< Hold back a partial segment while earlier data is unacknowledged (Nagle)
+    bool cork = false;             //!< Start corked: send only full segments until a flush or uncork
+    bool gso = false;              //!< Send super-segments that are split into MSS-sized segments when serialized
+    bool repacketize = false;      //!< Merge small in-flight segments into full ones when retransmitting them
+    bool window_scale = false;     //!< Offer window scaling on our SYN, so windows above 64 KB can be advertised
+    bool timestamps = false;       //!< Offer timestamps on our SYN, for RTT samples from every ACK and PAWS
+    uint16_t mss = MAX_PAYLOAD_SIZE;  //!< Largest payload this host sends or receives, offered on our SYN
+    bool plpmtud = false;  //!< Start at MAX_PAYLOAD_SIZE and probe for the largest payload the path carries
+    bool ecn = false;    //!< Negotiate ECN on our SYN: send data ECN-capable, and slow down when the peer echoes marks
+    bool dctcp = false;  //!< With ECN, cut the window in proportion to the marked fraction (DCTCP), echoing exactly
+    uint16_t ack_delay = 0;      //!< Hold the ACK for in-order data up to this many ms (0: ACK every segment)
+    unsigned ack_frequency = 2;  //!< With `ack_delay`, ACK at once when this many full segments are unacknowledged
+    //! TCP Fast Open cookie for the server, from a TCPFastOpenCache: data written before the first fill_window()
+    //! rides on our SYN. Empty asks the server for a cookie; unset disables Fast Open.
+    std::optional<std::string> fastopen_cookie{};
+    //! Grow the buffers with the connection's needs: the receive buffer to twice what the reader consumes per
+    //! round trip, the send buffer to twice the window in flight. `recv_capacity` and `send_capacity` are
+    //! where they start and the least they shrink to.
+    bool autotune = false;
+    size_t max_recv_capacity = 6 << 20;  //!< With `autotune`, the largest receive capacity, in bytes
+    size_t max_send_capacity = 4 << 20;  //!< With `autotune`, the largest send capacity, in bytes
+    //! With `autotune`, the budget that growth beyond `recv_capacity` and `send_capacity` is taken from, shared
+    //! by all the connections given it (none: growth is limited only by the maximums)
+    std::shared_ptr<TCPMemoryBudget> memory_budget{};
+
+    //! Window scale shift that lets an advertisement describe all of `recv_capacity` (RFC 7323 section 2.3),
+    //! or all of `max_recv_capacity` with `autotune`, since the shift is fixed by the SYN
+    uint8_t window_shift() const {
+        const size_t capacity = autotune ? std::max(recv_capacity, max_recv_capacity) : recv_capacity;
+        uint8_t shift = 0;
+        while (shift < TCPHeader::MAX_WINDOW_SHIFT && (capacity >> shift) > UINT16_MAX)
+            shift++;
+        return shift;
+    }
 };
 
 //! Config for classes derived from FdAdapter
@@ -0,0 +1,76 @@
+#include "tcp_fastopen.hh"
+
+#include <random>
+
+using namespace std;
+
+static uint64_t rotl(const uint64_t x, const int b) { return (x << b) | (x >> (64 - b)); }
+
+static void sip_round(uint64_t &v0, uint64_t &v1, uint64_t &v2, uint64_t &v3) {
+    v0 += v1;
+    v1 = rotl(v1, 13);
+    v1 ^= v0;
+    v0 = rotl(v0, 32);
+    v2 += v3;
+    v3 = rotl(v3, 16);
+    v3 ^= v2;
+    v0 += v3;
+    v3 = rotl(v3, 21);
+    v3 ^= v0;
+    v2 += v1;
+    v1 = rotl(v1, 17);
+    v1 ^= v2;
+    v2 = rotl(v2, 32);
+}
+
+//! SipHash-2-4 of `data` under the key (k0, k1)
+static uint64_t siphash(const uint64_t k0, const uint64_t k1, const string &data) {
+    uint64_t v0 = k0 ^ 0x736f6d6570736575ULL;
+    uint64_t v1 = k1 ^ 0x646f72616e646f6dULL;
+    uint64_t v2 = k0 ^ 0x6c7967656e657261ULL;
+    uint64_t v3 = k1 ^ 0x7465646279746573ULL;
+
+    const size_t len = data.size();
+    uint64_t word = 0;
+    for (size_t i = 0; i <= len; i++) {
+        // The final word holds the leftover bytes and, in its top byte, the message length.
+        if (i == len)
+            word |= uint64_t{len & 0xff} << 56;
+        else
+            word |= uint64_t{static_cast<uint8_t>(data[i])} << (8 * (i % 8));
+        if (i % 8 == 7 || i == len) {
+            v3 ^= word;
+            sip_round(v0, v1, v2, v3);
+            sip_round(v0, v1, v2, v3);
+            v0 ^= word;
+            word = 0;
+        }
+    }
+
+    v2 ^= 0xff;
+    for (int i = 0; i < 4; i++)
+        sip_round(v0, v1, v2, v3);
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+TCPFastOpenKey::TCPFastOpenKey() : _k0(0), _k1(0) {
+    random_device rd;
+    _k0 = (uint64_t{rd()} << 32) | rd();
+    _k1 = (uint64_t{rd()} << 32) | rd();
+}
+
+//! \param[in] client the client's address; only the IP address is hashed, so the cookie is good for any port
+string TCPFastOpenKey::cookie(const Address &client) const {
+    const uint64_t hash = siphash(_k0, _k1, client.ip());
+    string ret(COOKIE_LENGTH, '\0');
+    for (size_t i = 0; i < COOKIE_LENGTH; i++)
+        ret[i] = static_cast<char>(hash >> (8 * i));
+    return ret;
+}
+
+optional<string> TCPFastOpenCache::cookie(const Address &server) const {
+    const auto it = _cookies.find(server.ip());
+    if (it == _cookies.end())
+        return nullopt;
+    return it->second;
+}
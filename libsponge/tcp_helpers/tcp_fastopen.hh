@@ -0,0 +1,49 @@
+#ifndef SPONGE_LIBSPONGE_TCP_FASTOPEN_HH
+#define SPONGE_LIBSPONGE_TCP_FASTOPEN_HH
+
+#include "address.hh"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+//! \brief Server side of [TCP Fast Open](https://tools.ietf.org/html/rfc7413): issues cookies
+//!
+//! A cookie is a keyed hash (SipHash-2-4) of the client's IP address, so the server can check the cookie on a
+//! SYN without keeping per-client state. Changing the key invalidates every cookie issued under the old one.
+class TCPFastOpenKey {
+  private:
+    uint64_t _k0;
+    uint64_t _k1;
+
+  public:
+    static constexpr size_t COOKIE_LENGTH = 8;  //!< length of the cookies issued, in bytes
+
+    //! Construct with a random key
+    TCPFastOpenKey();
+
+    //! Construct with a fixed key (e.g. shared by the servers behind one address)
+    TCPFastOpenKey(const uint64_t k0, const uint64_t k1) : _k0(k0), _k1(k1) {}
+
+    //! The cookie issued to `client`
+    std::string cookie(const Address &client) const;
+};
+
+//! \brief Client side of TCP Fast Open: the cookies that servers have issued to us, by server IP address
+class TCPFastOpenCache {
+  private:
+    std::unordered_map<std::string, std::string> _cookies{};
+
+  public:
+    //! The cookie to present to `server`, if one is known
+    std::optional<std::string> cookie(const Address &server) const;
+
+    //! Remember the cookie that `server` issued
+    void insert(const Address &server, const std::string &cookie) { _cookies[server.ip()] = cookie; }
+
+    //! Forget the cookie for `server` (e.g. after its SYN-ACK ignored the data on our SYN)
+    void erase(const Address &server) { _cookies.erase(server.ip()); }
+};
+
+#endif  // SPONGE_LIBSPONGE_TCP_FASTOPEN_HH
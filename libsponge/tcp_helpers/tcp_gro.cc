@@ -0,0 +1,62 @@
+#include "tcp_gro.hh"
+
+#include "tcp_config.hh"
+
+using namespace std;
+
+size_t TCPGROSegment::payload_size() const {
+    size_t size = segment.payload().size();
+    for (const auto &payload : more_payload)
+        size += payload.size();
+    return size;
+}
+
+//! \param[in] seg a segment that would carry data, and may be merged
+static bool mergeable(const TCPSegment &seg) {
+    const TCPHeader &header = seg.header();
+    return seg.payload().size() > 0 && !header.syn && !header.fin && !header.rst && !header.urg;
+}
+
+bool TCPGRO::_can_extend(const TCPSegment &seg) const {
+    const TCPSegment &first = _run.value().segment;
+    const Buffer &last = _run.value().more_payload.empty() ? first.payload() : _run.value().more_payload.back();
+    const TCPHeader &a = first.header();
+    const TCPHeader &b = seg.header();
+
+    // The next bytes, in a segment no larger than the first, following only full-sized segments
+    if (!mergeable(seg) || a.psh || b.seqno != a.seqno + _run_payload || last.size() != first.payload().size() ||
+        seg.payload().size() > first.payload().size() ||
+        _run_payload + seg.payload().size() > TCPConfig::MAX_GSO_PAYLOAD_SIZE)
+        return false;
+
+    // The same connection, acknowledgment, window, flags and options, and the same ECN codepoint
+    return a.sport == b.sport && a.dport == b.dport && a.ack == b.ack && a.ackno == b.ackno && a.win == b.win &&
+           a.ece == b.ece && a.cwr == b.cwr && a.doff == b.doff && a.timestamps == b.timestamps &&
+           a.sack_blocks == b.sack_blocks && a.unknown_options == b.unknown_options && first.ect() == seg.ect() &&
+           first.ce() == seg.ce();
+}
+
+void TCPGRO::push(const TCPSegment &seg) {
+    if (_run.has_value() && _can_extend(seg)) {
+        _run.value().more_payload.push_back(seg.payload());
+        _run.value().segment.header().psh = seg.header().psh;
+        _run_payload += seg.payload().size();
+        return;
+    }
+
+    flush();
+    if (!mergeable(seg)) {
+        _segments_out.push({seg, {}});
+        return;
+    }
+    _run = TCPGROSegment{seg, {}};
+    _run_payload = seg.payload().size();
+}
+
+void TCPGRO::flush() {
+    if (!_run.has_value())
+        return;
+    _segments_out.push(std::move(_run.value()));
+    _run.reset();
+    _run_payload = 0;
+}
@@ -0,0 +1,54 @@
+#ifndef SPONGE_LIBSPONGE_TCP_GRO_HH
+#define SPONGE_LIBSPONGE_TCP_GRO_HH
+
+#include "buffer.hh"
+#include "tcp_segment.hh"
+
+#include <optional>
+#include <queue>
+#include <vector>
+
+//! \brief A run of back-to-back in-order segments, merged by TCPGRO into one logical segment
+struct TCPGROSegment {
+    //! the run's first segment, with PSH taken from its last: the header of the whole run, and its first payload
+    TCPSegment segment{};
+
+    //! payloads of the rest of the run, in order; they share the received segments' storage
+    std::vector<Buffer> more_payload{};
+
+    //! number of received segments in the run
+    size_t count() const { return 1 + more_payload.size(); }
+
+    //! payload bytes in the run
+    size_t payload_size() const;
+};
+
+//! \brief Generic receive offload: merges back-to-back in-order segments of one connection before the TCPReceiver
+//!
+//! Segments pushed in arrival order are gathered into runs. A segment joins the run before it when it carries the
+//! next bytes and a header that differs only in sequence number and PSH, and when the segments so far were all
+//! full-sized (a shorter segment or PSH ends a run). SYN, FIN, RST and URG segments, pure ACKs, and a change in the
+//! CE mark are never merged, so the receiver still sees every flag, window and option that matters. The TCPReceiver
+//! then does its per-segment work once per run.
+class TCPGRO {
+  private:
+    std::queue<TCPGROSegment> _segments_out{};
+
+    //! the run being gathered, and its payload size
+    std::optional<TCPGROSegment> _run{};
+    size_t _run_payload{0};
+
+    bool _can_extend(const TCPSegment &seg) const;
+
+  public:
+    //! \brief A segment was received: add it to the run being gathered, or release that run and start another
+    void push(const TCPSegment &seg);
+
+    //! \brief The batch of received segments has ended: release the run being gathered
+    void flush();
+
+    //! \brief Runs ready for TCPReceiver::segment_received(), in arrival order
+    std::queue<TCPGROSegment> &segments_out() { return _segments_out; }
+};
+
+#endif  // SPONGE_LIBSPONGE_TCP_GRO_HH
@@ -1,9 +1,115 @@
 #include "tcp_header.hh"
 
+#include "util.hh"
+
+#include <arpa/inet.h>
+#include <cstring>
 #include <sstream>
 
 using namespace std;
 
+//! \name TCP option kinds
+//!@{
+static constexpr uint8_t OPT_EOL = 0;             //!< end of option list
+static constexpr uint8_t OPT_NOP = 1;             //!< no-operation (padding)
+static constexpr uint8_t OPT_MSS = 2;             //!< maximum segment size (RFC 9293)
+static constexpr uint8_t OPT_WINDOW_SCALE = 3;    //!< window scale (RFC 7323)
+static constexpr uint8_t OPT_SACK_PERMITTED = 4;  //!< SACK permitted (RFC 2018)
+static constexpr uint8_t OPT_SACK = 5;            //!< SACK blocks (RFC 2018)
+static constexpr uint8_t OPT_TIMESTAMPS = 8;      //!< timestamps (RFC 7323)
+static constexpr uint8_t OPT_FASTOPEN = 34;       //!< TCP Fast Open cookie (RFC 7413)
+//!@}
+
+//! Whether `kind` is an option with a field of its own in TCPHeader (malformed ones are dropped, not kept)
+static bool understood(const uint8_t kind) {
+    return kind == OPT_MSS or kind == OPT_WINDOW_SCALE or kind == OPT_SACK_PERMITTED or kind == OPT_SACK or
+           kind == OPT_TIMESTAMPS or kind == OPT_FASTOPEN;
+}
+
+//! `len` rounded up to a multiple of four
+static size_t aligned(const size_t len) { return (len + 3) & ~size_t{3}; }
+
+static uint16_t load_u16(const uint8_t *bytes) { return (bytes[0] << 8) | bytes[1]; }
+
+static uint32_t load_u32(const uint8_t *bytes) {
+    return (uint32_t{load_u16(bytes)} << 16) | load_u16(bytes + 2);
+}
+
+//! Whether an unknown option of `len` bytes can be kept: it fits in the store, and the header can still be
+//! serialized with it (the unknown options are written together, then padded to four bytes)
+static bool unknown_option_fits(const TCPHeader &hdr, const size_t len) {
+    const size_t kept = hdr.unknown_options.size();
+    return kept + len <= hdr.unknown_options.capacity() and
+           TCPHeader::LENGTH + hdr.options_length() - aligned(kept) + aligned(kept + len) <= TCPHeader::MAX_LENGTH;
+}
+
+//! \param[out] hdr is the TCPHeader whose option fields will be filled in
+//! \param[in] options are the option bytes announced by the `doff` field
+//! \details The options are read straight from the bytes, without a bounds check per field. Unknown options are
+//!          kept while there is room for them, in the store and in the header once the options are aligned again
+//!          (see TCPHeader::options_length()). A malformed option length ends option processing without failing
+//!          the parse, since the rest of the header is still usable.
+static void parse_options(TCPHeader &hdr, const string_view options) {
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(options.data());
+    const size_t len = options.size();
+
+    // What most segments carry once timestamps are on: two NOPs, then the timestamps option
+    if (len == 12 and load_u32(bytes) == 0x0101'080a) {
+        hdr.timestamps = TCPTimestamps{load_u32(bytes + 4), load_u32(bytes + 8)};
+        return;
+    }
+
+    for (size_t i = 0; i < len;) {
+        const uint8_t kind = bytes[i];
+        if (kind == OPT_EOL) {
+            break;
+        }
+        if (kind == OPT_NOP) {
+            i++;
+            continue;
+        }
+        if (i + 1 == len) {
+            break;
+        }
+        const size_t opt_len = bytes[i + 1];
+        if (opt_len < 2 or opt_len > len - i) {
+            break;
+        }
+        const uint8_t *body = bytes + i + 2;
+        const size_t body_len = opt_len - 2;
+        if (kind == OPT_MSS and body_len == 2) {
+            hdr.mss = load_u16(body);
+        } else if (kind == OPT_SACK_PERMITTED and body_len == 0) {
+            hdr.sack_permitted = true;
+        } else if (kind == OPT_WINDOW_SCALE and body_len == 1) {
+            hdr.window_scale = body[0];
+        } else if (kind == OPT_TIMESTAMPS and body_len == 8) {
+            hdr.timestamps = TCPTimestamps{load_u32(body), load_u32(body + 4)};
+        } else if (kind == OPT_FASTOPEN and body_len <= TCPHeader::MAX_FASTOPEN_COOKIE_LENGTH) {
+            hdr.fastopen_cookie = options.substr(i + 2, body_len);
+        } else if (kind == OPT_SACK and body_len % 8 == 0) {
+            for (size_t block = 0; block < body_len / 8; block++) {
+                hdr.sack_blocks.push_back({WrappingInt32{load_u32(body + 8 * block)},
+                                           WrappingInt32{load_u32(body + 8 * block + 4)}});
+            }
+        } else if (not understood(kind) and unknown_option_fits(hdr, opt_len)) {
+            for (size_t j = 0; j < opt_len; j++) {
+                hdr.unknown_options.push_back(bytes[i + j]);
+            }
+        }
+        i += opt_len;
+    }
+
+    // Options are written back aligned, which can take more room than they arrived in: drop what was kept
+    // least usefully until the header can be serialized again.
+    if (TCPHeader::LENGTH + hdr.options_length() > TCPHeader::MAX_LENGTH) {
+        hdr.unknown_options.clear();
+    }
+    while (TCPHeader::LENGTH + hdr.options_length() > TCPHeader::MAX_LENGTH and not hdr.sack_blocks.empty()) {
+        hdr.sack_blocks.pop_back();
+    }
+}
+
 //! \param[in,out] p is a NetParser from which the TCP fields will be extracted
 //! \returns a ParseResult indicating success or the reason for failure
 //! \details It is important to check for (at least) the following potential errors
@@ -22,6 +128,8 @@ ParseResult TCPHeader::parse(NetParser &p) {
     doff = p.u8() >> 4;              // data offset
 
     const uint8_t fl_b = p.u8();                  // byte including flags
+    cwr = static_cast<bool>(fl_b & 0b1000'0000);
+    ece = static_cast<bool>(fl_b & 0b0100'0000);
     urg = static_cast<bool>(fl_b & 0b0010'0000);  // binary literals and ' digit separator since C++14!!!
     ack = static_cast<bool>(fl_b & 0b0001'0000);
     psh = static_cast<bool>(fl_b & 0b0000'1000);
@@ -37,8 +145,19 @@ ParseResult TCPHeader::parse(NetParser &p) {
         return ParseResult::HeaderTooShort;
     }
 
-    // skip any options or anything extra in the header
-    p.remove_prefix(doff * 4 - TCPHeader::LENGTH);
+    mss.reset();
+    sack_permitted = false;
+    sack_blocks.clear();
+    window_scale.reset();
+    timestamps.reset();
+    fastopen_cookie.reset();
+    unknown_options.clear();
+
+    const size_t options_len = doff * 4 - TCPHeader::LENGTH;
+    if (not p.error() and options_len > 0) {
+        parse_options(*this, p.buffer().str().substr(0, options_len));
+    }
+    p.remove_prefix(options_len);
 
     if (p.error()) {
         return p.get_error();
@@ -47,34 +166,202 @@ ParseResult TCPHeader::parse(NetParser &p) {
     return ParseResult::NoError;
 }
 
+//! \details Each option starts on a four-byte boundary, with NOPs in front or behind as needed; SACK-permitted
+//! shares its word with the timestamps option, if both are present.
+size_t TCPHeader::options_length() const {
+    size_t len = 0;
+    if (mss.has_value()) {
+        len += 4;
+    }
+    if (timestamps.has_value()) {
+        len += 12;  // SACK-permitted or two NOPs, then the 10-byte option
+    } else if (sack_permitted) {
+        len += 4;  // two NOPs, then the 2-byte option
+    }
+    if (window_scale.has_value()) {
+        len += 4;  // NOP, then the 3-byte option
+    }
+    if (fastopen_cookie.has_value()) {
+        len += aligned(2 + fastopen_cookie.value().size());
+    }
+    if (not sack_blocks.empty()) {
+        len += 4 + 8 * sack_blocks.size();  // two NOPs, then the option
+    }
+    return len + aligned(unknown_options.size());
+}
+
+namespace {
+
+//! Stores big-endian fields into a serialized header, and sums them as 16-bit words (as InternetChecksum does)
+//! while it has them in registers, so that the header need not be read again to checksum it
+class HeaderWriter {
+  private:
+    TCPHeader::Bytes &_out;
+    size_t _length{0};
+    uint32_t _sum{0};
+
+  public:
+    explicit HeaderWriter(TCPHeader::Bytes &out) : _out(out) {}
+
+    void u8(const uint8_t val) {
+        _out[_length] = val;
+        _sum += _length % 2 == 0 ? uint32_t{val} << 8 : val;
+        _length++;
+    }
+
+    void u16(const uint16_t val) {
+        if (_length % 2 == 1) {
+            u8(val >> 8);
+            u8(val & 0xff);
+            return;
+        }
+        const uint16_t net = htons(val);
+        memcpy(_out.data() + _length, &net, sizeof(net));
+        _sum += val;
+        _length += sizeof(net);
+    }
+
+    void u32(const uint32_t val) {
+        if (_length % 2 == 1) {
+            u16(val >> 16);
+            u16(val & 0xffff);
+            return;
+        }
+        const uint32_t net = htonl(val);
+        memcpy(_out.data() + _length, &net, sizeof(net));
+        _sum += (val >> 16) + (val & 0xffff);
+        _length += sizeof(net);
+    }
+
+    void bytes(const string_view str) {
+        for (const char c : str) {
+            u8(static_cast<uint8_t>(c));
+        }
+    }
+
+    //! Pad with NOP options to a multiple of four bytes
+    void nop_pad() {
+        while (_length % 4 != 0) {
+            u8(OPT_NOP);
+        }
+    }
+
+    //! Expand the header to `length` bytes with zeros, which are EOL options and add nothing to the sum
+    void pad_to(const size_t length) {
+        memset(_out.data() + _length, 0, length - _length);
+        _length = length;
+    }
+
+    size_t length() const { return _length; }
+
+    //! The partial checksum (see InternetChecksum::partial()) of what has been written
+    uint16_t partial_sum() const {
+        uint32_t sum = _sum;
+        while (sum > 0xffff) {
+            sum = (sum >> 16) + (sum & 0xffff);
+        }
+        return sum;
+    }
+};
+
+}  // namespace
+
 //! Serialize the TCPHeader to a string (does not recompute the checksum)
 string TCPHeader::serialize() const {
+    Bytes out;
+    const size_t length = serialize_into(out);
+    return string(reinterpret_cast<const char *>(out.data()), length);
+}
+
+//! \param[out] out where to write the header
+size_t TCPHeader::serialize_into(Bytes &out) const {
+    InternetChecksum unused;
+    return serialize_into(out, unused);
+}
+
+//! \param[out] out where to write the header
+//! \param[in,out] check the checksum to add the header's bytes to, including the `cksum` field as it is
+//! \note The data offset written is the larger of `doff` and the length needed to hold the options
+size_t TCPHeader::serialize_into(Bytes &out, InternetChecksum &check) const {
     // sanity check
     if (doff < 5) {
         throw runtime_error("TCP header too short");
     }
+    if (LENGTH + options_length() > MAX_LENGTH) {
+        throw runtime_error("TCP options too long");
+    }
+    const uint8_t doff_out = max(doff, static_cast<uint8_t>((LENGTH + options_length()) / 4));
+
+    HeaderWriter w{out};
 
-    string ret;
-    ret.reserve(4 * doff);
+    w.u16(sport);              // source port
+    w.u16(dport);              // destination port
+    w.u32(seqno.raw_value());  // sequence number
+    w.u32(ackno.raw_value());  // ack number
+    w.u8(doff_out << 4);       // data offset
 
-    NetUnparser::u16(ret, sport);              // source port
-    NetUnparser::u16(ret, dport);              // destination port
-    NetUnparser::u32(ret, seqno.raw_value());  // sequence number
-    NetUnparser::u32(ret, ackno.raw_value());  // ack number
-    NetUnparser::u8(ret, doff << 4);           // data offset
+    const uint8_t fl_b = (cwr ? 0b1000'0000 : 0) | (ece ? 0b0100'0000 : 0) | (urg ? 0b0010'0000 : 0) |
+                         (ack ? 0b0001'0000 : 0) | (psh ? 0b0000'1000 : 0) | (rst ? 0b0000'0100 : 0) |
+                         (syn ? 0b0000'0010 : 0) | (fin ? 0b0000'0001 : 0);
+    w.u8(fl_b);  // flags
+    w.u16(win);  // window size
 
-    const uint8_t fl_b = (urg ? 0b0010'0000 : 0) | (ack ? 0b0001'0000 : 0) | (psh ? 0b0000'1000 : 0) |
-                         (rst ? 0b0000'0100 : 0) | (syn ? 0b0000'0010 : 0) | (fin ? 0b0000'0001 : 0);
-    NetUnparser::u8(ret, fl_b);  // flags
-    NetUnparser::u16(ret, win);  // window size
+    w.u16(cksum);  // checksum
 
-    NetUnparser::u16(ret, cksum);  // checksum
+    w.u16(uptr);  // urgent pointer
 
-    NetUnparser::u16(ret, uptr);  // urgent pointer
+    // Each option is aligned as options_length() describes.
+    if (mss.has_value()) {
+        w.u8(OPT_MSS);
+        w.u8(4);
+        w.u16(mss.value());
+    }
+    if (timestamps.has_value() or sack_permitted) {
+        if (sack_permitted) {
+            w.u8(OPT_SACK_PERMITTED);
+            w.u8(2);
+        } else {
+            w.u16(0x0101);  // two NOPs
+        }
+        if (timestamps.has_value()) {
+            w.u8(OPT_TIMESTAMPS);
+            w.u8(10);
+            w.u32(timestamps.value().tsval);
+            w.u32(timestamps.value().tsecr);
+        } else {
+            w.u16(0x0101);
+        }
+    }
+    if (window_scale.has_value()) {
+        w.u8(OPT_NOP);
+        w.u8(OPT_WINDOW_SCALE);
+        w.u8(3);
+        w.u8(window_scale.value());
+    }
+    if (fastopen_cookie.has_value()) {
+        w.u8(OPT_FASTOPEN);
+        w.u8(2 + fastopen_cookie.value().size());
+        w.bytes(fastopen_cookie.value());
+        w.nop_pad();
+    }
+    if (not sack_blocks.empty()) {
+        w.u16(0x0101);
+        w.u8(OPT_SACK);
+        w.u8(2 + 8 * sack_blocks.size());
+        for (const auto &block : sack_blocks) {
+            w.u32(block.left.raw_value());
+            w.u32(block.right.raw_value());
+        }
+    }
+    for (const uint8_t byte : unknown_options) {
+        w.u8(byte);
+    }
+    w.nop_pad();
 
-    ret.resize(4 * doff);  // expand header to advertised size
+    w.pad_to(4 * doff_out);  // expand header to advertised size (zero bytes are EOL options)
 
-    return ret;
+    check.add_partial(w.partial_sum(), w.length());
+    return w.length();
 }
 
 //! \returns A string with the header's contents
@@ -85,24 +372,46 @@ string TCPHeader::to_string() const {
        << "TCP seqno: " << seqno << '\n'
        << "TCP ackno: " << ackno << '\n'
        << "TCP doff: " << +doff << '\n'
-       << "Flags: urg: " << urg << " ack: " << ack << " psh: " << psh << " rst: " << rst << " syn: " << syn
-       << " fin: " << fin << '\n'
+       << "Flags: cwr: " << cwr << " ece: " << ece << " urg: " << urg << " ack: " << ack << " psh: " << psh
+       << " rst: " << rst << " syn: " << syn << " fin: " << fin << '\n'
        << "TCP winsize: " << +win << '\n'
        << "TCP cksum: " << +cksum << '\n'
-       << "TCP uptr: " << +uptr << '\n';
+       << "TCP uptr: " << +uptr << '\n'
+       << "TCP sack_permitted: " << sack_permitted << '\n';
+    if (mss.has_value()) {
+        ss << "TCP mss: " << +mss.value() << '\n';
+    }
+    if (window_scale.has_value()) {
+        ss << "TCP window scale: " << +window_scale.value() << '\n';
+    }
+    if (timestamps.has_value()) {
+        ss << "TCP timestamps: " << timestamps.value().tsval << ' ' << timestamps.value().tsecr << '\n';
+    }
+    if (fastopen_cookie.has_value()) {
+        ss << "TCP fastopen cookie length: " << fastopen_cookie.value().size() << '\n';
+    }
+    for (const auto &block : sack_blocks) {
+        ss << "TCP sack: " << block.left << '-' << block.right << '\n';
+    }
+    if (not unknown_options.empty()) {
+        ss << "TCP unknown options length: " << unknown_options.size() << '\n';
+    }
     return ss.str();
 }
 
 string TCPHeader::summary() const {
     stringstream ss{};
     ss << "Header(flags=" << (syn ? "S" : "") << (ack ? "A" : "") << (rst ? "R" : "") << (fin ? "F" : "")
-       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win << ")";
+       << (ece ? "E" : "") << (cwr ? "C" : "") << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win << ")";
     return ss.str();
 }
 
 bool TCPHeader::operator==(const TCPHeader &other) const {
     // TODO(aozdemir) more complete check (right now we omit cksum, src, dst
-    return seqno == other.seqno && ackno == other.ackno && doff == other.doff && urg == other.urg && ack == other.ack &&
-           psh == other.psh && rst == other.rst && syn == other.syn && fin == other.fin && win == other.win &&
-           uptr == other.uptr;
+    return seqno == other.seqno && ackno == other.ackno && doff == other.doff && cwr == other.cwr &&
+           ece == other.ece && urg == other.urg && ack == other.ack && psh == other.psh && rst == other.rst &&
+           syn == other.syn && fin == other.fin && win == other.win && uptr == other.uptr && mss == other.mss &&
+           sack_permitted == other.sack_permitted && sack_blocks == other.sack_blocks &&
+           window_scale == other.window_scale && timestamps == other.timestamps &&
+           fastopen_cookie == other.fastopen_cookie && unknown_options == other.unknown_options;
 }
@@ -4,10 +4,150 @@
 #include "parser.hh"
 #include "wrapping_integers.hh"
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+class InternetChecksum;
+
+//! \brief A SACK block (RFC 2018): the peer holds the sequence numbers in [left, right)
+struct TCPSACKBlock {
+    WrappingInt32 left{0};   //!< first sequence number of the block
+    WrappingInt32 right{0};  //!< sequence number immediately following the block
+
+    bool operator==(const TCPSACKBlock &other) const { return left == other.left && right == other.right; }
+};
+
+//! \brief The timestamps option ([RFC 7323](\ref rfc::rfc7323)): the sender's clock, and the last one it received
+struct TCPTimestamps {
+    uint32_t tsval{0};  //!< timestamp value: the sender's clock when the segment was sent
+    uint32_t tsecr{0};  //!< timestamp echo reply: the most recent TSval received from the peer
+
+    bool operator==(const TCPTimestamps &other) const { return tsval == other.tsval && tsecr == other.tsecr; }
+};
+
+//! \brief A list of at most `N` items of a TCP option, stored inline, so that parsing or copying a header
+//! never allocates
+template <typename T, size_t N>
+class TCPOptionList {
+  private:
+    std::array<T, N> _items{};
+    uint8_t _size{0};
+
+  public:
+    static constexpr size_t capacity() { return N; }
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    bool full() const { return _size == N; }
+    void clear() { _size = 0; }
+
+    //! \note Throws std::length_error if the list is full()
+    void push_back(const T &item) {
+        if (full()) {
+            throw std::length_error("TCPOptionList::push_back: list is full");
+        }
+        _items[_size++] = item;
+    }
+    void pop_back() { _size--; }
+
+    const T &operator[](const size_t i) const { return _items[i]; }
+    T &operator[](const size_t i) { return _items[i]; }
+    const T &front() const { return _items[0]; }
+    const T &back() const { return _items[_size - 1]; }
+
+    const T *begin() const { return _items.data(); }
+    const T *end() const { return _items.data() + _size; }
+    T *begin() { return _items.data(); }
+    T *end() { return _items.data() + _size; }
+
+    bool operator==(const TCPOptionList &other) const { return std::equal(begin(), end(), other.begin(), other.end()); }
+    bool operator!=(const TCPOptionList &other) const { return not(*this == other); }
+};
+
+//! \brief The TCP Fast Open option ([RFC 7413](https://tools.ietf.org/html/rfc7413)), stored inline: absent,
+//! empty (a request for a cookie), or a cookie
+//! \details Converts to and from `std::optional<std::string>`, which is how cookies are held elsewhere.
+class TCPFastOpenCookieOption {
+  public:
+    static constexpr size_t MAX_LENGTH = 16;  //!< longest cookie
+
+  private:
+    std::array<char, MAX_LENGTH> _bytes{};
+    uint8_t _length{0};
+    bool _present{false};
+
+  public:
+    TCPFastOpenCookieOption() = default;
+    TCPFastOpenCookieOption(std::nullopt_t) {}
+
+    //! \note Throws std::length_error if `cookie` is longer than MAX_LENGTH
+    TCPFastOpenCookieOption(const std::string_view cookie) : _length(cookie.size()), _present(true) {
+        if (cookie.size() > MAX_LENGTH) {
+            throw std::length_error("TCP Fast Open cookie too long");
+        }
+        std::copy(cookie.begin(), cookie.end(), _bytes.begin());
+    }
+    TCPFastOpenCookieOption(const std::string &cookie) : TCPFastOpenCookieOption(std::string_view{cookie}) {}
+    TCPFastOpenCookieOption(const std::optional<std::string> &cookie) {
+        if (cookie.has_value()) {
+            *this = TCPFastOpenCookieOption(cookie.value());
+        }
+    }
+
+    bool has_value() const { return _present; }
+    explicit operator bool() const { return _present; }
+    void reset() { _present = false; }
+
+    //! \note Throws std::bad_optional_access unless has_value()
+    std::string_view value() const {
+        if (not _present) {
+            throw std::bad_optional_access();
+        }
+        return {_bytes.data(), _length};
+    }
+
+    operator std::optional<std::string>() const {
+        return _present ? std::optional<std::string>{std::string{value()}} : std::nullopt;
+    }
+
+    bool operator==(const TCPFastOpenCookieOption &other) const {
+        return _present == other._present and (not _present or value() == other.value());
+    }
+    bool operator!=(const TCPFastOpenCookieOption &other) const { return not(*this == other); }
+};
+
+//! \name Compare with a cookie held as a `std::optional<std::string>`
+//!@{
+inline bool operator==(const TCPFastOpenCookieOption &a, const std::optional<std::string> &b) {
+    return a.has_value() == b.has_value() and (not a.has_value() or a.value() == b.value());
+}
+inline bool operator!=(const TCPFastOpenCookieOption &a, const std::optional<std::string> &b) { return not(a == b); }
+//!@}
+
 //! \brief [TCP](\ref rfc::rfc793) segment header
-//! \note TCP options are not supported
+//! \note The MSS, SACK-permitted, SACK, window scale, timestamps and Fast Open options are parsed into their own
+//! fields. Other options are kept as they arrived, up to MAX_UNKNOWN_OPTIONS_LENGTH bytes of them, and sent
+//! again after the ones understood; any beyond that are dropped. No option is stored on the heap.
 struct TCPHeader {
-    static constexpr size_t LENGTH = 20;  //!< [TCP](\ref rfc::rfc793) header length, not including options
+    static constexpr size_t LENGTH = 20;          //!< [TCP](\ref rfc::rfc793) header length, not including options
+    static constexpr size_t MAX_LENGTH = 60;      //!< largest header that the 4-bit `doff` field can describe
+    static constexpr size_t MAX_SACK_BLOCKS = 4;  //!< most SACK blocks that fit in the option space
+    static constexpr size_t MAX_SACK_BLOCKS_WITH_TIMESTAMPS = 3;  //!< most that fit alongside timestamps
+    static constexpr uint8_t MAX_WINDOW_SHIFT = 14;  //!< largest window scale shift ([RFC 7323](\ref rfc::rfc7323))
+    static constexpr size_t MAX_FASTOPEN_COOKIE_LENGTH = TCPFastOpenCookieOption::MAX_LENGTH;  //!< longest cookie
+    static constexpr size_t MAX_UNKNOWN_OPTIONS_LENGTH = 12;  //!< most bytes of options not understood that are kept
+    static constexpr size_t SEQNO_OFFSET = 4;      //!< where the seqno is, in bytes from the start
+    static constexpr size_t FLAGS_OFFSET = 12;     //!< where the 16-bit word of data offset and flags is
+    static constexpr size_t CHECKSUM_OFFSET = 16;  //!< where the checksum field is, in bytes from the start
+
+    //! Room for a serialized header of any length, e.g. on the stack
+    using Bytes = std::array<uint8_t, MAX_LENGTH>;
+
+    using SACKBlocks = TCPOptionList<TCPSACKBlock, MAX_SACK_BLOCKS>;  //!< the blocks of a SACK option
 
     //! \struct TCPHeader
     //! ~~~{.txt}
@@ -20,9 +160,9 @@ struct TCPHeader {
     //!  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
     //!  |                    Acknowledgment Number                      |
     //!  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-    //!  |  Data |           |U|A|P|R|S|F|                               |
-    //!  | Offset| Reserved  |R|C|S|S|Y|I|            Window             |
-    //!  |       |           |G|K|H|T|N|N|                               |
+    //!  |  Data |       |C|E|U|A|P|R|S|F|                               |
+    //!  | Offset| Rsrvd |W|C|R|C|S|S|Y|I|            Window             |
+    //!  |       |       |R|E|G|K|H|T|N|N|                               |
     //!  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
     //!  |           Checksum            |         Urgent Pointer        |
     //!  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
@@ -39,6 +179,8 @@ struct TCPHeader {
     WrappingInt32 seqno{0};     //!< sequence number
     WrappingInt32 ackno{0};     //!< ack number
     uint8_t doff = LENGTH / 4;  //!< data offset
+    bool cwr = false;           //!< congestion window reduced flag ([RFC 3168](https://tools.ietf.org/html/rfc3168))
+    bool ece = false;           //!< ECN-echo flag ([RFC 3168](https://tools.ietf.org/html/rfc3168))
     bool urg = false;           //!< urgent flag
     bool ack = false;           //!< ack flag
     bool psh = false;           //!< push flag
@@ -50,12 +192,36 @@ struct TCPHeader {
     uint16_t uptr = 0;          //!< urgent pointer
     //!@}
 
+    //! \name TCP options
+    //!@{
+    std::optional<uint16_t> mss{};            //!< maximum segment size (only meaningful on a SYN)
+    bool sack_permitted = false;              //!< SACK-permitted option (only meaningful on a SYN)
+    std::optional<uint8_t> window_scale{};    //!< window scale shift (only meaningful on a SYN)
+    std::optional<TCPTimestamps> timestamps{};  //!< timestamps option
+    SACKBlocks sack_blocks{};                   //!< SACK option blocks
+    TCPFastOpenCookieOption fastopen_cookie{};  //!< TCP Fast Open cookie; empty requests one (only on a SYN)
+
+    //! Options not understood, each with its kind and length bytes, in the order they arrived
+    TCPOptionList<uint8_t, MAX_UNKNOWN_OPTIONS_LENGTH> unknown_options{};
+    //!@}
+
+    //! Length of the options, in bytes, once each is padded with NOPs to a multiple of four
+    size_t options_length() const;
+
     //! Parse the TCP fields from the provided NetParser
     ParseResult parse(NetParser &p);
 
     //! Serialize the TCP fields
     std::string serialize() const;
 
+    //! \brief Serialize the TCP fields into `out` without allocating, as serialize() does
+    //! \returns the number of bytes written, from the start of `out`
+    size_t serialize_into(Bytes &out) const;
+
+    //! \brief Serialize the TCP fields into `out`, and add them to `check` as they are written, in the same pass
+    //! \returns the number of bytes written, from the start of `out`
+    size_t serialize_into(Bytes &out, InternetChecksum &check) const;
+
     //! Return a string containing a header in human-readable format
     std::string to_string() const;
 
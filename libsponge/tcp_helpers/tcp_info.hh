@@ -0,0 +1,46 @@
+#ifndef SPONGE_LIBSPONGE_TCP_INFO_HH
+#define SPONGE_LIBSPONGE_TCP_INFO_HH
+
+#include <cstdint>
+#include <type_traits>
+
+//! \brief A snapshot of a connection's counters and timers, in the spirit of Linux's `TCP_INFO`
+//!
+//! A plain struct of integers: TCPSender::fill_info() and TCPReceiver::fill_info() each fill in their half
+//! without allocating or formatting strings, so a monitor can poll many connections often, and reuse one
+//! TCPInfo for all of them. Byte counts are payload bytes; SYN and FIN are not counted. The struct is trivial, so
+//! value-initialize it (`TCPInfo info{}`) to start from zeros.
+struct TCPInfo {
+    //! \name Filled in by TCPSender::fill_info()
+    //!@{
+    uint64_t bytes_sent;            //!< payload bytes sent, including retransmissions
+    uint64_t bytes_acked;           //!< payload bytes cumulatively acknowledged
+    uint64_t bytes_retransmitted;   //!< payload bytes sent again
+    uint64_t bytes_in_flight;       //!< sequence numbers sent but not yet acknowledged
+    uint64_t segments_out;          //!< wire segments sent, including retransmissions
+    uint64_t retransmissions;       //!< wire segments sent again, for any reason
+    uint64_t timeouts;              //!< expirations of the retransmission timer
+    uint32_t consecutive_timeouts;  //!< expirations since the last ACK of new data
+    uint32_t rto_ms;                //!< current retransmission timeout
+    uint64_t srtt_ms;               //!< smoothed round-trip time, if `rtt_valid`
+    uint64_t rttvar_ms;             //!< round-trip time variation, if `rtt_valid`
+    bool rtt_valid;                 //!< a round-trip time has been measured
+    uint64_t snd_wnd;               //!< the peer's window, in bytes
+    uint64_t mss;                   //!< payload size of the segments being sent
+    uint64_t snd_capacity;          //!< capacity of the outbound stream, which autotuning may change
+    //!@}
+
+    //! \name Filled in by TCPReceiver::fill_info()
+    //!@{
+    uint64_t bytes_received;      //!< payload bytes received, including duplicates
+    uint64_t segments_in;         //!< segments received, including those dropped
+    uint64_t rcv_wnd;             //!< receive window, in bytes
+    uint64_t out_of_order_bytes;  //!< bytes held beyond a hole, waiting to be reassembled
+    uint64_t reassembly_holes;    //!< gaps in the data held for reassembly
+    uint64_t rcv_capacity;        //!< capacity of the receive buffer, which autotuning may change
+    //!@}
+};
+
+static_assert(std::is_trivial_v<TCPInfo>, "TCPInfo is a plain snapshot");
+
+#endif  // SPONGE_LIBSPONGE_TCP_INFO_HH
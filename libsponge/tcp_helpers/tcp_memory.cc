@@ -0,0 +1,41 @@
+#include "tcp_memory.hh"
+
+#include <algorithm>
+#include <utility>
+
+using namespace std;
+
+//! \param[in] bytes the number of bytes wanted
+size_t TCPMemoryBudget::acquire(const size_t bytes) {
+    const size_t granted = min(bytes, _limit - min(_limit, _used));
+    _used += granted;
+    return granted;
+}
+
+//! \param[in] bytes the number of bytes given back
+void TCPMemoryBudget::release(const size_t bytes) { _used -= min(bytes, _used); }
+
+TCPMemoryShare::TCPMemoryShare(TCPMemoryShare &&other) noexcept
+    : _budget(std::move(other._budget)), _size(exchange(other._size, 0)) {}
+
+TCPMemoryShare &TCPMemoryShare::operator=(TCPMemoryShare &&other) noexcept {
+    if (this != &other) {
+        resize(0);
+        _budget = std::move(other._budget);
+        _size = exchange(other._size, 0);
+    }
+    return *this;
+}
+
+//! \param[in] size the number of bytes wanted in all
+size_t TCPMemoryShare::resize(const size_t size) {
+    if (size < _size and _budget) {
+        _budget->release(_size - size);
+    }
+    if (size <= _size or not _budget) {
+        _size = size;
+    } else {
+        _size += _budget->acquire(size - _size);
+    }
+    return _size;
+}
@@ -0,0 +1,61 @@
+#ifndef SPONGE_LIBSPONGE_TCP_MEMORY_HH
+#define SPONGE_LIBSPONGE_TCP_MEMORY_HH
+
+#include <cstddef>
+#include <memory>
+
+//! \brief A limit on buffer memory shared by many connections
+//!
+//! Buffer autotuning takes the growth of each connection's buffers beyond their configured capacity from here,
+//! so that the connections together stay under the limit (like Linux's `tcp_mem`).
+class TCPMemoryBudget {
+  private:
+    size_t _limit;
+    size_t _used{0};
+
+  public:
+    //! Construct a budget of `limit` bytes
+    explicit TCPMemoryBudget(const size_t limit) : _limit(limit) {}
+
+    //! \brief Take up to `bytes` from the budget
+    //! \returns the number of bytes granted
+    size_t acquire(const size_t bytes);
+
+    //! \brief Return `bytes` to the budget
+    void release(const size_t bytes);
+
+    //! \name Accessors
+    //!@{
+    size_t limit() const { return _limit; }
+    size_t used() const { return _used; }
+    //!@}
+};
+
+//! \brief One buffer's share of a TCPMemoryBudget, given back when it shrinks or is destroyed
+//! \note Without a budget, every request is granted in full.
+class TCPMemoryShare {
+  private:
+    std::shared_ptr<TCPMemoryBudget> _budget;
+    size_t _size{0};
+
+  public:
+    explicit TCPMemoryShare(std::shared_ptr<TCPMemoryBudget> budget = {}) : _budget(std::move(budget)) {}
+    ~TCPMemoryShare() { resize(0); }
+
+    //! \name A share belongs to one buffer: it can be moved but not copied
+    //!@{
+    TCPMemoryShare(const TCPMemoryShare &other) = delete;
+    TCPMemoryShare &operator=(const TCPMemoryShare &other) = delete;
+    TCPMemoryShare(TCPMemoryShare &&other) noexcept;
+    TCPMemoryShare &operator=(TCPMemoryShare &&other) noexcept;
+    //!@}
+
+    //! \brief Grow or shrink the share towards `size` bytes
+    //! \returns the size of the share, which is less than `size` if the budget ran out
+    size_t resize(const size_t size);
+
+    //! \brief The size of the share
+    size_t size() const { return _size; }
+};
+
+#endif  // SPONGE_LIBSPONGE_TCP_MEMORY_HH
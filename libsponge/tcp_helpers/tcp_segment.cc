@@ -3,6 +3,7 @@
 #include "parser.hh"
 #include "util.hh"
 
+#include <stdexcept>
 #include <variant>
 
 using namespace std;
@@ -11,7 +12,8 @@ using namespace std;
 //! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
 ParseResult TCPSegment::parse(const Buffer buffer, const uint32_t datagram_layer_checksum) {
     InternetChecksum check(datagram_layer_checksum);
-    check.add(buffer);
+    // Summing the buffer by its partial_sum() keeps the sum, which the payload inherits (see Buffer::remove_prefix).
+    check.add_buffer(buffer);
     if (check.value()) {
         return ParseResult::BadChecksum;
     }
@@ -19,6 +21,7 @@ ParseResult TCPSegment::parse(const Buffer buffer, const uint32_t datagram_layer
     NetParser p{buffer};
     _header.parse(p);
     _payload = p.buffer();
+    _gso_size = 0;
     return p.get_error();
 }
 
@@ -26,20 +29,145 @@ size_t TCPSegment::length_in_sequence_space() const {
     return payload().str().size() + (header().syn ? 1 : 0) + (header().fin ? 1 : 0);
 }
 
+size_t TCPSegment::wire_segment_count() const {
+    if (_gso_size == 0 || _payload.size() <= _gso_size) {
+        return 1;
+    }
+    return (_payload.size() + _gso_size - 1) / _gso_size;
+}
+
+namespace {
+
+//! Flag bits, in the 16-bit word at TCPHeader::FLAGS_OFFSET, that are not on every wire segment
+constexpr uint16_t FLAG_CWR = 0b1000'0000;
+constexpr uint16_t FLAG_PSH = 0b0000'1000;
+constexpr uint16_t FLAG_SYN = 0b0000'0010;
+constexpr uint16_t FLAG_FIN = 0b0000'0001;
+
+uint16_t load_u16(const TCPHeader::Bytes &bytes, const size_t offset) {
+    return static_cast<uint16_t>(bytes[offset] << 8 | bytes[offset + 1]);
+}
+
+void store_u16(TCPHeader::Bytes &bytes, const size_t offset, const uint16_t val) {
+    bytes[offset] = val >> 8;
+    bytes[offset + 1] = val & 0xff;
+}
+
+void store_u32(TCPHeader::Bytes &bytes, const size_t offset, const uint32_t val) {
+    store_u16(bytes, offset, val >> 16);
+    store_u16(bytes, offset + 2, val & 0xffff);
+}
+
+}  // namespace
+
 //! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
-BufferList TCPSegment::serialize(const uint32_t datagram_layer_checksum) const {
+//! \param[in] index which wire segment of a GSO super-segment to serialize
+//! \details A wire segment carries `gso_size()` bytes of the payload starting at `index * gso_size()`, with the
+//! seqno advanced to match. SYN and CWR stay on the first wire segment and FIN and PSH on the last; each wire
+//! segment gets its own checksum.
+BufferList TCPSegment::serialize(const uint32_t datagram_layer_checksum, const size_t index) const {
+    const size_t count = wire_segment_count();
+    if (index >= count) {
+        throw out_of_range("TCPSegment::serialize: no wire segment " + to_string(index));
+    }
+
+    InternetChecksum check(datagram_layer_checksum);
+    TCPHeader::Bytes header_bytes;
+
+    if (count > 1) {
+        const size_t header_length = _first_wire_header_into(header_bytes, check);
+        return _wire_segment(header_bytes, header_length, check.value(), index, false);
+    }
+
+    // calculate checksum -- taken over entire segment; the header is summed as it is written
     TCPHeader header_out = _header;
     header_out.cksum = 0;
+    const size_t header_length = header_out.serialize_into(header_bytes, check);
+    // The payload is summed by (and keeps its sum in) the member, not a copy.
+    check.add_buffer(_payload);
+    const uint16_t cksum = check.value();
+    store_u16(header_bytes, TCPHeader::CHECKSUM_OFFSET, cksum);
+
+    BufferList ret;
+    ret.append(Buffer{string(reinterpret_cast<const char *>(header_bytes.data()), header_length)});
+    ret.append(_payload);
+
+    return ret;
+}
+
+//! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol, leaving out the TCP length
+//! \details The pseudo-header includes the TCP length, which differs for a short last wire segment, so each wire
+//! segment's length is added to its checksum here. (serialize() takes a pseudo-checksum that includes it.)
+vector<BufferList> TCPSegment::serialize_wire_segments(const uint32_t datagram_layer_checksum) const {
+    const size_t count = wire_segment_count();
+    vector<BufferList> ret;
+    ret.reserve(count);
+    if (count == 1) {
+        const size_t header_length = max<size_t>(4 * _header.doff, TCPHeader::LENGTH + _header.options_length());
+        ret.push_back(serialize(datagram_layer_checksum + header_length + _payload.size()));
+        return ret;
+    }
 
-    // calculate checksum -- taken over entire segment
     InternetChecksum check(datagram_layer_checksum);
-    check.add(header_out.serialize());
-    check.add(_payload);
-    header_out.cksum = check.value();
+    TCPHeader::Bytes first;
+    const size_t header_length = _first_wire_header_into(first, check);
+    const uint16_t first_checksum = check.value();
+    for (size_t index = 0; index < count; index++) {
+        ret.push_back(_wire_segment(first, header_length, first_checksum, index, true));
+    }
+    return ret;
+}
+
+size_t TCPSegment::_first_wire_header_into(TCPHeader::Bytes &out, InternetChecksum &check) const {
+    TCPHeader first = _header;
+    first.cksum = 0;
+    first.fin = first.psh = false;
+    return first.serialize_into(out, check);
+}
+
+//! \param[in] first the first wire segment's header, from _first_wire_header_into()
+//! \param[in] header_length the length of `first`
+//! \param[in] first_checksum the checksum of `first` alone (with the lower-layer pseudo-checksum)
+//! \param[in] index which wire segment to make
+//! \param[in] add_length whether to add the wire segment's length, as the pseudo-header's TCP length, to the checksum
+//! \details Only the seqno and the flags differ from the first wire segment's header, so the header's checksum
+//! is updated for them incrementally ([RFC 1624](https://tools.ietf.org/html/rfc1624)) rather than summed again.
+BufferList TCPSegment::_wire_segment(const TCPHeader::Bytes &first,
+                                     const size_t header_length,
+                                     const uint16_t first_checksum,
+                                     const size_t index,
+                                     const bool add_length) const {
+    const size_t offset = index * _gso_size;
+    TCPHeader::Bytes header_bytes = first;
+    uint16_t header_checksum = first_checksum;
+
+    if (index > 0) {
+        const uint32_t first_seqno = _header.seqno.raw_value();
+        const uint32_t seqno = (_header.seqno + offset + (_header.syn ? 1 : 0)).raw_value();
+        const uint16_t first_flags = load_u16(first, TCPHeader::FLAGS_OFFSET);
+        uint16_t flags = first_flags & ~(FLAG_SYN | FLAG_CWR);
+        if (index + 1 == wire_segment_count()) {
+            flags |= (_header.fin ? FLAG_FIN : 0) | (_header.psh ? FLAG_PSH : 0);
+        }
+        store_u32(header_bytes, TCPHeader::SEQNO_OFFSET, seqno);
+        store_u16(header_bytes, TCPHeader::FLAGS_OFFSET, flags);
+        header_checksum = InternetChecksum::update_u32(header_checksum, first_seqno, seqno);
+        header_checksum = InternetChecksum::update_u16(header_checksum, first_flags, flags);
+    }
+
+    Buffer payload_out = _payload;
+    payload_out.remove_prefix(offset);
+    payload_out.remove_suffix(payload_out.size() - min(payload_out.size(), _gso_size));
+
+    // The header's length is a multiple of four, so the payload's sum continues from the header's.
+    const size_t tcp_length = add_length ? header_length + payload_out.size() : 0;
+    InternetChecksum check(uint32_t{static_cast<uint16_t>(~header_checksum)} + tcp_length);
+    check.add_buffer(payload_out);
+    store_u16(header_bytes, TCPHeader::CHECKSUM_OFFSET, check.value());
 
     BufferList ret;
-    ret.append(header_out.serialize());
-    ret.append(_payload);
+    ret.append(Buffer{string(reinterpret_cast<const char *>(header_bytes.data()), header_length)});
+    ret.append(payload_out);
 
     return ret;
 }
@@ -5,19 +5,45 @@
 #include "tcp_header.hh"
 
 #include <cstdint>
+#include <vector>
 
 //! \brief [TCP](\ref rfc::rfc793) segment
 class TCPSegment {
   private:
-    TCPHeader _header{};
+    // The header follows the 8-byte-aligned members, so that the flags fill the end of its last word.
     Buffer _payload{};
+    size_t _gso_size{0};
+    TCPHeader _header{};
+    bool _ect{false};
+    bool _ce{false};
+
+    //! Write the header of a super-segment's first wire segment, with a zero checksum, and add it to `check`
+    size_t _first_wire_header_into(TCPHeader::Bytes &out, InternetChecksum &check) const;
+
+    //! One wire segment of a super-segment, made from the first one's header by patching what differs
+    BufferList _wire_segment(const TCPHeader::Bytes &first,
+                             const size_t header_length,
+                             const uint16_t first_checksum,
+                             const size_t index,
+                             const bool add_length) const;
 
   public:
     //! \brief Parse the segment from a string
     ParseResult parse(const Buffer buffer, const uint32_t datagram_layer_checksum = 0);
 
-    //! \brief Serialize the segment to a string
-    BufferList serialize(const uint32_t datagram_layer_checksum = 0) const;
+    //! \brief Serialize the segment (or one wire segment of a GSO super-segment) to a string
+    //! \note Unless the payload is split, its Buffer::partial_sum() is kept, so serializing the segment again
+    //! (e.g. to retransmit it, perhaps with a new ackno or window) sums only the header.
+    BufferList serialize(const uint32_t datagram_layer_checksum = 0, const size_t index = 0) const;
+
+    //! \brief Serialize every wire segment, as serialize() does for each `index`, writing and summing the header
+    //! only once
+    //! \note `datagram_layer_checksum` leaves out the pseudo-header's TCP length, which is added for each wire segment
+    std::vector<BufferList> serialize_wire_segments(const uint32_t datagram_layer_checksum = 0) const;
+
+    //! \brief Number of wire segments that serialize() produces, one per `index`
+    //! \note 1 unless the payload is longer than gso_size()
+    size_t wire_segment_count() const;
 
     //! \name Accessors
     //!@{
@@ -26,6 +52,19 @@ class TCPSegment {
 
     const Buffer &payload() const { return _payload; }
     Buffer &payload() { return _payload; }
+
+    //! \brief Largest payload of one wire segment when a super-segment is split (0 means never split)
+    size_t gso_size() const { return _gso_size; }
+    size_t &gso_size() { return _gso_size; }
+
+    //! \brief The segment is sent ECN-capable (ECT), so the path may mark it instead of dropping it
+    //! \note Like ce(), this belongs to the IP header, and is carried here until there is an IP layer.
+    bool ect() const { return _ect; }
+    bool &ect() { return _ect; }
+
+    //! \brief The segment arrived marked Congestion Experienced (CE) by the path
+    bool ce() const { return _ce; }
+    bool &ce() { return _ce; }
     //!@}
 
     //! \brief Segment's length in sequence space
@@ -1,13 +1,116 @@
 #include "tcp_receiver.hh"
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 
+TCPReceiver::TCPReceiver(const TCPConfig &config) : TCPReceiver(config.recv_capacity) {
+    if (config.window_scale)
+        _window_shift_offered = config.window_shift();
+    _timestamps_offered = config.timestamps;
+    _ecn_offered = config.ecn;
+    _dctcp = config.dctcp;
+    _ack_delay = config.ack_delay;
+    _ack_frequency = config.ack_frequency;
+    _mss = config.mss;
+    _rcv_mss = std::min<size_t>(_rcv_mss, _mss);
+    _autotune = config.autotune;
+    _max_capacity = std::max(config.max_recv_capacity, _capacity);
+    _memory = TCPMemoryShare{config.memory_budget};
+}
+
+void TCPReceiver::tick(const size_t ms_since_last_tick) {
+    _now += ms_since_last_tick;
+    _autotune_capacity();
+}
+
 void TCPReceiver::segment_received(const TCPSegment &seg) {
+    static const std::vector<Buffer> no_more_payload{};
+    _segment_received(seg, no_more_payload, true);
+}
+
+void TCPReceiver::segment_received(const TCPGROSegment &run) {
+    _segment_received(run.segment, run.more_payload, true);
+}
+
+void TCPReceiver::segments_received(const std::vector<TCPSegment> &batch) {
+    // Until a SYN arrives there is no ISN to sort by.
+    size_t first = 0;
+    while (first < batch.size() && _state == LISTEN)
+        segment_received(batch[first++]);
+
+    // PAWS runs in arrival order, as it would one segment at a time: a retransmission sorted ahead of data sent
+    // before it must not raise TS.Recent past that data's TSval. Then sort the rest by absolute seqno, keeping
+    // arrival order among equals.
+    const uint64_t checkpoint = _reassembler.assembled_idx();
+    _batch.clear();
+    for (size_t i = first; i < batch.size(); i++) {
+        const uint64_t abs_seqno = unwrap(batch[i].header().seqno, _isn, checkpoint);
+        if (!_paws_accept(batch[i].header(), abs_seqno)) {
+            _segments_received++;
+            _bytes_received += batch[i].payload().size();
+            continue;
+        }
+        _batch.emplace_back(abs_seqno, i);
+    }
+    std::stable_sort(_batch.begin(), _batch.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+
+    // A data segment whose range an earlier one in the batch covers is a duplicate: it is counted, and calls for
+    // an ACK as it would have alone, but is not processed.
+    uint64_t covered = 0;
+    for (const auto &entry : _batch) {
+        const TCPSegment &seg = batch[entry.second];
+        const uint64_t end = entry.first + seg.length_in_sequence_space();
+        if (seg.payload().size() > 0 && !seg.header().syn && !seg.header().fin && end <= covered) {
+            _segments_received++;
+            _bytes_received += seg.payload().size();
+            _ack_now = true;
+            continue;
+        }
+        covered = std::max(covered, end);
+        _gro.push(seg);
+    }
+    _gro.flush();
+
+    for (; !_gro.segments_out().empty(); _gro.segments_out().pop()) {
+        const TCPGROSegment &run = _gro.segments_out().front();
+        _segment_received(run.segment, run.more_payload, false);
+    }
+}
+
+//! \details PAWS: a TSval older than TS.Recent marks an old duplicate, possibly from a previous wrap of the sequence
+//! space. Otherwise TS.Recent follows segments that start at or before the ackno (RFC 7323 section 4.3).
+//! \returns false if the segment is to be dropped (and acknowledged at once)
+bool TCPReceiver::_paws_accept(const TCPHeader &header, const uint64_t abs_seqno) {
+    if (!_timestamps || !header.timestamps.has_value())
+        return true;
+    const uint32_t tsval = header.timestamps.value().tsval;
+    if (_ts_recent.has_value() && !header.rst && static_cast<int32_t>(tsval - _ts_recent.value()) < 0) {
+        _ack_now = true;
+        return false;
+    }
+    if (abs_seqno <= _reassembler.assembled_idx() + 1)
+        _ts_recent = tsval;
+    return true;
+}
+
+//! \param[in] seg the segment, or the first of a run merged by TCPGRO, with the run's header
+//! \param[in] more_payload the payloads of the rest of the run, which follow seg's in sequence space
+//! \param[in] check_paws false if segments_received() has already run the PAWS check
+void TCPReceiver::_segment_received(const TCPSegment &seg,
+                                    const std::vector<Buffer> &more_payload,
+                                    const bool check_paws) {
     bool is_syn = seg.header().syn;
     bool is_fin = seg.header().fin;
     WrappingInt32 seq_no = seg.header().seqno;
-    std::string payload = seg.payload().copy();
+    // Views of the payload: the reassembler trims them to what is new and in the window, and keeps slices of
+    // large in-order ones (see StreamReassembler::push_substring).
+    bool accept_payload = true;
+    size_t len = seg.payload().size();
+    for (const auto &payload : more_payload)
+        len += payload.size();
+    _segments_received += 1 + more_payload.size();
+    _bytes_received += len;
 
     if (_state == LISTEN) {
         if (!is_syn)
@@ -16,31 +119,172 @@ void TCPReceiver::segment_received(const TCPSegment &seg) {
         // pushed by the reassembler.
         _state = SYN_RECV;
         _isn = WrappingInt32(seq_no);
+        _sack_permitted = seg.header().sack_permitted;
+        if (_window_shift_offered.has_value() && seg.header().window_scale.has_value())
+            _window_shift = _window_shift_offered.value();
+        _timestamps = _timestamps_offered && seg.header().timestamps.has_value();
+        // A SYN asks for ECN with ECE and CWR; a SYN-ACK agrees with ECE alone (RFC 3168 section 6.1.1).
+        _ecn = _ecn_offered && seg.header().ece && (seg.header().ack ? !seg.header().cwr : seg.header().cwr);
+    }
+
+    // With Fast Open enabled, the data (and any FIN) on a SYN is only accepted along with a valid cookie; otherwise
+    // just the SYN is acknowledged and the client sends the data again (RFC 7413 section 4.2.2).
+    if (is_syn && _fastopen_cookie.has_value() && seg.header().fastopen_cookie != _fastopen_cookie) {
+        accept_payload = false;
+        len = 0;
+        is_fin = false;
+        _fastopen_cookie_requested |= seg.header().fastopen_cookie.has_value();
     }
 
     uint64_t abs_seqno = unwrap(seq_no, _isn, _reassembler.assembled_idx());
+    const uint64_t assembled_before = _reassembler.assembled_idx();
+    const bool in_order = _reassembler.empty() && abs_seqno == assembled_before + 1;
+    const bool ece_before = _ece;
+
+    if (check_paws && !_paws_accept(seg.header(), abs_seqno))
+        return;
 
     // The abs_seqno of 0 is for SYN, which indicates that 0 is an illegal index for a segment without the SYN
     // flag.
     if (abs_seqno == 0 && !is_syn)
         return;
 
+    if (_ecn)
+        _ece = _dctcp ? seg.ce() : (_ece && !seg.header().cwr) || seg.ce();
+
+    // Each payload goes to the reassembler in turn, with the FIN on the last.
+    auto push = [&](uint64_t index) {
+        _reassembler.push_substring(accept_payload ? seg.payload() : Buffer{}, index, is_fin && more_payload.empty());
+        index += seg.payload().size();
+        for (size_t i = 0; accept_payload && i < more_payload.size(); i++) {
+            _reassembler.push_substring(more_payload[i], index, is_fin && i + 1 == more_payload.size());
+            index += more_payload[i].size();
+        }
+    };
+
     if (_state == SYN_RECV) {
         if (is_fin)
             _state = FIN_RECV;
         // For the payload associated with the SYN segment, the index for writing is abs_seqno (which is exactly 0).
         // For later payloads, the index is abs_seqno - 1 (check out the handout of lab2).
-        _reassembler.push_substring(payload, is_syn ? 0 : abs_seqno - 1, is_fin);
+        push(is_syn ? 0 : abs_seqno - 1);
+        if (len > 0 && !is_syn && abs_seqno - 1 > _reassembler.assembled_idx())
+            _last_out_of_order = abs_seqno - 1;
     }
 
     if (_state == FIN_RECV) {
         // Some previous segments may have been lost.
         if (!_reassembler.stream_out().input_ended())
-            _reassembler.push_substring(payload, abs_seqno - 1, is_fin);
+            push(abs_seqno - 1);
+    }
+
+    _schedule_ack(seg.header(), len, seg.payload().size(), assembled_before, in_order, ece_before);
+    _autotune_measure_rtt();
+    _autotune_capacity();
+}
+
+//! \details Without timestamps to echo, the receiver's view of the round trip is how long it takes for data to
+//! arrive beyond the edge of the window last advertised, which the sender can only send once our ACK has reached it
+//! (as in Linux's tcp_rcv_rtt_measure). While the buffer is more than half full, the window is held back by the
+//! reader rather than the path, so no measurement is taken.
+void TCPReceiver::_autotune_measure_rtt() {
+    if (!_autotune || _state == LISTEN)
         return;
+    const uint64_t assembled = _reassembler.assembled_idx();
+    const bool reader_bound = stream_out().buffer_size() > _capacity / 2;
+    if (_rtt_seq != 0 && assembled >= _rtt_seq) {
+        const uint64_t sample = std::max<uint64_t>(_now - _rtt_time, 1);
+        if (!reader_bound)
+            _rcv_rtt = _rcv_rtt == 0 ? sample : (7 * _rcv_rtt + sample) / 8;
+        _rtt_seq = 0;
+    }
+    if (_rtt_seq == 0 && !reader_bound) {
+        _rtt_seq = std::max(_window_right, assembled) + 1;
+        _rtt_time = _now;
     }
 }
 
+void TCPReceiver::_autotune_capacity() {
+    if (!_autotune || _rcv_rtt == 0 || _now - _space_time < _rcv_rtt)
+        return;
+
+    const uint64_t read = stream_out().bytes_read();
+    const uint64_t copied = read - _space_copied;
+    _space_time = _now;
+    _space_copied = read;
+
+    size_t target = _capacity;
+    if (2 * copied > _capacity)
+        target = 2 * copied;
+    else if (4 * copied < _capacity)
+        target = _capacity / 2;
+    target = std::min(std::max(target, _base_capacity), _max_capacity);
+
+    // The bytes the peer has been told it may send must still fit.
+    const uint64_t promised = std::max(_window_right, _reassembler.assembled_idx()) - read;
+    target = std::max<size_t>(target, promised);
+    if (target == _capacity)
+        return;
+
+    _capacity = _base_capacity + _memory.resize(target - _base_capacity);
+    _reassembler.set_capacity(_capacity);
+}
+
+//! \param[in] header the header of the segment (or run of segments) just received
+//! \param[in] len its payload size
+//! \param[in] segment_size the payload size of its first segment
+//! \param[in] assembled_before the number of bytes assembled before it arrived
+//! \param[in] in_order it began at the ackno, with nothing held out of order
+//! \param[in] ece_before the ECE flag before it arrived
+void TCPReceiver::_schedule_ack(const TCPHeader &header,
+                                const size_t len,
+                                const size_t segment_size,
+                                const uint64_t assembled_before,
+                                const bool in_order,
+                                const bool ece_before) {
+    // Pure ACKs are not acknowledged.
+    if (len == 0 && !header.syn && !header.fin)
+        return;
+
+    _rcv_mss = std::max(_rcv_mss, std::min(segment_size, _mss));
+    _unacked_bytes += len;
+
+    // Only new in-order data that was accepted whole may wait; anything else tells the sender something at once
+    // (a duplicate may be a retransmission that is waiting on our ACK, and out-of-order data triggers fast
+    // retransmit).
+    const bool accepted = in_order && _reassembler.empty() && _reassembler.assembled_idx() == assembled_before + len;
+    if (_ack_delay == 0 || header.syn || header.fin || !accepted || _ece != ece_before ||
+        _unacked_bytes >= _ack_frequency * _rcv_mss) {
+        _ack_now = true;
+        return;
+    }
+    if (!_ack_deadline.has_value())
+        _ack_deadline = _now + _ack_delay;
+}
+
+bool TCPReceiver::ack_due() const {
+    if (_state == LISTEN)
+        return false;
+    if (_ack_now || (_ack_deadline.has_value() && _now >= _ack_deadline.value()))
+        return true;
+    return window_update_due();
+}
+
+bool TCPReceiver::window_update_due() const {
+    if (_state == LISTEN)
+        return false;
+    const uint64_t peer_window = _window_right - std::min(_window_right, _reassembler.assembled_idx());
+    const size_t window = advertised_window();
+    return window > peer_window && window >= 2 * peer_window;
+}
+
+void TCPReceiver::ack_sent() {
+    _ack_now = false;
+    _ack_deadline.reset();
+    _unacked_bytes = 0;
+    _window_right = _reassembler.assembled_idx() + advertised_window();
+}
+
 std::optional<WrappingInt32> TCPReceiver::ackno() const {
     if (_state == LISTEN)
         return std::nullopt;
@@ -51,3 +295,58 @@ std::optional<WrappingInt32> TCPReceiver::ackno() const {
 }
 
 size_t TCPReceiver::window_size() const { return _capacity - (_reassembler.stream_out().buffer_size()); }
+
+size_t TCPReceiver::advertised_window() const {
+    const uint64_t left = _reassembler.assembled_idx();
+    const uint64_t right = left + window_size();
+    if (right >= _window_right + std::min(_mss, _capacity / 2))
+        return window_size();
+    return _window_right - std::min(_window_right, left);
+}
+
+uint16_t TCPReceiver::window_advertisement() {
+    const auto advertisement =
+        static_cast<uint16_t>(std::min<size_t>(advertised_window() >> _window_shift, UINT16_MAX));
+    const uint64_t right = _reassembler.assembled_idx() + (uint64_t{advertisement} << _window_shift);
+    _window_right = std::max(_window_right, right);
+    return advertisement;
+}
+
+//! \param[out] info the snapshot; the sender's fields are left alone
+void TCPReceiver::fill_info(TCPInfo &info) const {
+    info.bytes_received = _bytes_received;
+    info.segments_in = _segments_received;
+    info.rcv_wnd = advertised_window();
+    info.out_of_order_bytes = _reassembler.unassembled_bytes();
+    info.reassembly_holes = _reassembler.hole_count();
+    info.rcv_capacity = _capacity;
+}
+
+std::vector<TCPSACKBlock> TCPReceiver::sack_blocks() const {
+    std::vector<TCPSACKBlock> blocks;
+    if (!_sack_permitted || _state == LISTEN)
+        return blocks;
+
+    const auto ranges = _reassembler.unassembled_ranges();
+    auto to_block = [this](const std::pair<uint64_t, uint64_t> &range) {
+        // Stream index i is carried by absolute seqno i + 1 (the SYN occupies absolute seqno 0).
+        return TCPSACKBlock{wrap(range.first + 1, _isn), wrap(range.second + 1, _isn)};
+    };
+
+    // The block holding the most recent out-of-order arrival goes first.
+    auto recent = ranges.end();
+    if (_last_out_of_order.has_value()) {
+        const uint64_t idx = _last_out_of_order.value();
+        recent = std::find_if(ranges.begin(), ranges.end(), [idx](const std::pair<uint64_t, uint64_t> &range) {
+            return range.first <= idx && idx < range.second;
+        });
+        if (recent != ranges.end())
+            blocks.push_back(to_block(*recent));
+    }
+    const size_t max_blocks = _timestamps ? TCPHeader::MAX_SACK_BLOCKS_WITH_TIMESTAMPS : TCPHeader::MAX_SACK_BLOCKS;
+    for (auto it = ranges.begin(); it != ranges.end() && blocks.size() < max_blocks; it++) {
+        if (it != recent)
+            blocks.push_back(to_block(*it));
+    }
+    return blocks;
+}
@@ -3,10 +3,17 @@
 
 #include "byte_stream.hh"
 #include "stream_reassembler.hh"
+#include "tcp_config.hh"
+#include "tcp_fastopen.hh"
+#include "tcp_gro.hh"
+#include "tcp_info.hh"
+#include "tcp_memory.hh"
 #include "tcp_segment.hh"
 #include "wrapping_integers.hh"
 
 #include <optional>
+#include <string>
+#include <vector>
 
 enum ReceiverState { LISTEN, SYN_RECV, FIN_RECV, RERROR };
 
@@ -26,13 +33,122 @@ class TCPReceiver {
 
     WrappingInt32 _isn;
 
+    //! The peer's SYN carried SACK-permitted, so we may send SACK blocks.
+    bool _sack_permitted{false};
+
+    //! Stream index of the most recent segment that arrived out of order (reported first in SACK).
+    std::optional<uint64_t> _last_out_of_order{};
+
+    //! Our SYN offers window scaling with this shift, if set.
+    std::optional<uint8_t> _window_shift_offered{};
+
+    //! The shift applied to our window advertisements, once the peer's SYN accepted our offer.
+    uint8_t _window_shift{0};
+
+    //! Our SYN offers timestamps, and whether the peer's SYN carried them too.
+    bool _timestamps_offered{false};
+    bool _timestamps{false};
+
+    //! TS.Recent: the TSval to echo, and the floor below which segments are old duplicates (PAWS).
+    std::optional<uint32_t> _ts_recent{};
+
+    //! Our SYN offers ECN, and whether the peer's SYN agreed.
+    bool _ecn_offered{false};
+    bool _ecn{false};
+
+    //! Echo each segment's CE mark exactly (DCTCP) instead of until the sender answers with CWR.
+    bool _dctcp{false};
+
+    //! ECE for the next segment to the peer.
+    bool _ece{false};
+
+    //! TCP Fast Open: the cookie a client's SYN must present for its data to be accepted, once enabled.
+    std::optional<std::string> _fastopen_cookie{};
+
+    //! The client's SYN asked for a cookie, or presented a stale one, so our SYN-ACK issues one.
+    bool _fastopen_cookie_requested{false};
+
+    //! Segments and payload bytes received, for fill_info().
+    uint64_t _segments_received{0};
+    uint64_t _bytes_received{0};
+
+    //! Delayed ACKs: in-order data is acknowledged after at most `_ack_delay` ms (0 acknowledges every segment),
+    //! or once `_ack_frequency` full-sized segments of it are unacknowledged.
+    uint64_t _ack_delay{0};
+    uint64_t _ack_frequency{2};
+
+    //! Our MSS, and the largest payload received up to it: the size of a full-sized segment from the peer.
+    size_t _mss{TCPConfig::MAX_PAYLOAD_SIZE};
+    size_t _rcv_mss{536};
+
+    //! The receiver's clock (ms passed to tick()), and when the ACK being held must be sent.
+    uint64_t _now{0};
+    std::optional<uint64_t> _ack_deadline{};
+
+    //! Payload bytes received since the last ACK.
+    uint64_t _unacked_bytes{0};
+
+    //! The last segment called for an ACK straight away.
+    bool _ack_now{false};
+
+    //! Stream index just past the window advertised on the last ACK (initially, the window implied by the SYN).
+    //! Silly window syndrome avoidance moves it forward only in steps of min(MSS, capacity / 2).
+    uint64_t _window_right;
+
+    //! Reused by segments_received(): the batch's absolute seqnos and indices, and the runs it merges into.
+    std::vector<std::pair<uint64_t, size_t>> _batch{};
+    TCPGRO _gro{};
+
+    //! Receive buffer autotuning: the capacity moves between the configured one and `_max_capacity`, and growth
+    //! beyond the configured capacity is held as a share of the memory budget.
+    bool _autotune{false};
+    size_t _base_capacity;
+    size_t _max_capacity;
+    TCPMemoryShare _memory{};
+
+    //! The receiver's RTT estimate, in ms (0 until measured), and the measurement under way, if `_rtt_seq` is set:
+    //! the time from `_rtt_time` until the stream reaches `_rtt_seq`, just past the window edge advertised then.
+    uint64_t _rcv_rtt{0};
+    uint64_t _rtt_seq{0};
+    uint64_t _rtt_time{0};
+
+    //! When the current autotuning interval began, and how many bytes the reader had read by then.
+    uint64_t _space_time{0};
+    uint64_t _space_copied{0};
+
+    void _segment_received(const TCPSegment &seg, const std::vector<Buffer> &more_payload, const bool check_paws);
+
+    bool _paws_accept(const TCPHeader &header, const uint64_t abs_seqno);
+
+    void _schedule_ack(const TCPHeader &header,
+                       const size_t len,
+                       const size_t segment_size,
+                       const uint64_t assembled_before,
+                       const bool in_order,
+                       const bool ece);
+
+    void _autotune_measure_rtt();
+
+    void _autotune_capacity();
+
   public:
     //! \brief Construct a TCP receiver
     //!
     //! \param capacity the maximum number of bytes that the receiver will
     //!                 store in its buffers at any give time.
     TCPReceiver(const size_t capacity)
-        : _reassembler(capacity), _capacity(capacity), _state(LISTEN), _isn(WrappingInt32(0)) {}
+        : _reassembler(capacity)
+        , _capacity(capacity)
+        , _state(LISTEN)
+        , _isn(WrappingInt32(0))
+        , _window_right(capacity)
+        , _base_capacity(capacity)
+        , _max_capacity(capacity) {}
+
+    //! \brief Construct a TCP receiver from a connection's configuration
+    //! \note `recv_capacity` may exceed 64 KB; with `window_scale` set it is advertised in full
+    //! once the peer's SYN accepts the window scale option.
+    explicit TCPReceiver(const TCPConfig &config);
 
     //! \name Accessors to provide feedback to the remote TCPSender
     //!@{
@@ -44,7 +160,7 @@ class TCPReceiver {
     //! of the first byte in the stream that the receiver hasn't received.
     std::optional<WrappingInt32> ackno() const;
 
-    //! \brief The window size that should be sent to the peer
+    //! \brief The window size, to the byte, before silly window syndrome avoidance
     //!
     //! Operationally: the capacity minus the number of bytes that the
     //! TCPReceiver is holding in its byte stream (those that have been
@@ -55,14 +171,113 @@ class TCPReceiver {
     //! accepted by the receiver) and (b) the sequence number of the
     //! beginning of the window (the ackno).
     size_t window_size() const;
+
+    //! \brief The window to advertise to the peer, with receiver-side silly window syndrome avoidance
+    //!
+    //! The right edge of the advertised window only moves forward once the reader has made room for at least
+    //! min(MSS, capacity / 2) more bytes, so that a reader draining a few bytes at a time does not invite a
+    //! stream of tiny segments ([RFC 1122](https://tools.ietf.org/html/rfc1122) section 4.2.3.3). Until then
+    //! the advertised window shrinks as data arrives, and may be zero while window_size() is not.
+    size_t advertised_window() const;
+
+    //! \brief The value for the window field of a segment to the peer
+    //!
+    //! The advertised_window() scaled down by the negotiated shift (rounded down), and clamped to
+    //! what the 16-bit field can hold. Segments carrying SYN use an unscaled window instead.
+    //! \note The right edge this advertises is recorded as what the peer has been told, for silly window
+    //! syndrome avoidance and window_update_due(), so it should be called for each segment sent to the peer.
+    uint16_t window_advertisement();
+
+    //! \brief Whether the reader has opened the window enough for a window update to be sent to the peer
+    //! \details True once the advertised window has grown to at least twice what the peer was last told remains
+    //! of it, so that a sender held back by a small or zero window does not wait on its persist timer.
+    bool window_update_due() const;
+
+    //! \brief The shift applied to window advertisements (0 unless window scaling was negotiated)
+    uint8_t window_shift() const { return _window_shift; }
     //!@}
 
+    //! \brief SACK blocks describing the out-of-order data we hold ([RFC 2018](https://tools.ietf.org/html/rfc2018))
+    //! \returns empty unless the peer's SYN carried SACK-permitted
+    //!
+    //! The first block contains the most recently received out-of-order segment; the rest follow in
+    //! sequence order, up to TCPHeader::MAX_SACK_BLOCKS in total (one fewer when timestamps are in use,
+    //! so that both options fit).
+    std::vector<TCPSACKBlock> sack_blocks() const;
+
+    //! \brief The TSecr to echo in the timestamps option of a segment to the peer
+    //! \returns empty unless both SYNs carried timestamps and one has been received
+    std::optional<uint32_t> ts_recent() const { return _ts_recent; }
+
+    //! \brief The ECE flag for the next segment to the peer
+    //! \details Once ECN is negotiated, a segment marked CE sets ECE. With DCTCP, ECE then reflects the mark on the
+    //! most recent segment; otherwise it stays set until a segment with CWR arrives
+    //! ([RFC 3168](https://tools.ietf.org/html/rfc3168) section 6.1.3).
+    bool ece() const { return _ece; }
+
+    //! \brief The TCP Fast Open cookie to put on our SYN-ACK
+    //! \returns empty unless Fast Open is enabled and the client's SYN asked for a cookie or presented a stale one
+    std::optional<std::string> fastopen_cookie() const {
+        return _fastopen_cookie_requested ? _fastopen_cookie : std::nullopt;
+    }
+
+    //! \brief Accept data on a SYN only from a client presenting the cookie that `key` issues to `client`
+    //! ([TCP Fast Open](https://tools.ietf.org/html/rfc7413))
+    //! \note Until this is called, data on a SYN is accepted whether or not it carries a cookie.
+    void enable_fastopen(const TCPFastOpenKey &key, const Address &client) { _fastopen_cookie = key.cookie(client); }
+
     //! \brief number of bytes stored but not yet reassembled
     size_t unassembled_bytes() const { return _reassembler.unassembled_bytes(); }
 
+    //! \name Delayed ACKs ([RFC 9293](https://tools.ietf.org/html/rfc9293) section 3.8.6.3)
+    //!@{
+
+    //! \brief Whether a segment carrying our ackno and window should be sent to the peer now
+    //! \details Without `ack_delay` every segment that occupies sequence space calls for an ACK. With it, in-order
+    //! data is acknowledged once `ack_frequency` full-sized segments are unacknowledged or the delay runs out.
+    //! SYN, FIN, out-of-order and duplicate data, data that fills a hole, a change to ECE, and the window opening
+    //! to twice what the peer was last told are all acknowledged at once.
+    bool ack_due() const;
+
+    //! \brief When the ACK being held must be sent, in ms on the clock advanced by tick(), if one is held
+    //! \note An event loop should call tick() no later than this time.
+    std::optional<uint64_t> ack_deadline() const { return _ack_deadline; }
+
+    //! \brief A segment carrying our ackno and window was sent to the peer (a pure ACK, or with data)
+    void ack_sent();
+
+    //! \brief Notifies the TCPReceiver of the passage of time
+    void tick(const size_t ms_since_last_tick);
+    //!@}
+
+    //! \brief The receive buffer's capacity: the configured one, unless autotuning has changed it
+    //! \details With `autotune`, once per round trip (measured as the time until data arrives beyond the advertised
+    //! window) the capacity grows to twice the bytes the reader consumed in that round trip, or halves if the
+    //! reader consumed less than a quarter of it, like Linux's dynamic right-sizing. It never falls below the
+    //! configured capacity, nor so far that the window already advertised to the peer would be taken back.
+    size_t capacity() const { return _capacity; }
+
+    //! \brief Fill in the receiver's half of `info` (see TCPInfo)
+    void fill_info(TCPInfo &info) const;
+
     //! \brief handle an inbound segment
+    //! \note With timestamps, a segment whose TSval is older than TS.Recent is an old duplicate and is
+    //! dropped (PAWS, [RFC 7323](\ref rfc::rfc7323) section 5).
     void segment_received(const TCPSegment &seg);
 
+    //! \brief handle a run of inbound segments merged by TCPGRO, as one segment
+    void segment_received(const TCPGROSegment &run);
+
+    //! \brief handle a batch of inbound segments (e.g. from one recvmmsg call) at once
+    //!
+    //! The segments are sorted by sequence number, unwrapped against one checkpoint; those whose sequence range
+    //! the batch already covers are dropped, and back-to-back segments are merged as by TCPGRO, so each run goes
+    //! through the reassembler and the ACK policy once. ackno(), advertised_window() and ack_due() then describe
+    //! the whole batch. Segments that arrive before the SYN are taken one at a time, in arrival order.
+    //! \note PAWS and TS.Recent see the segments in arrival order, as they would one at a time; CE marks are seen
+    //! in sequence order.
+    void segments_received(const std::vector<TCPSegment> &batch);
+
     //! \name "Output" interface for the reader
     //!@{
     ByteStream &stream_out() { return _reassembler.stream_out(); }
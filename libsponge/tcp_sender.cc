@@ -1,8 +1,11 @@
 #include "tcp_sender.hh"
 
 #include "tcp_config.hh"
+#include "util.hh"
 
+#include <algorithm>
 #include <iostream>
+#include <numeric>
 #include <random>
 
 using namespace std;
@@ -14,7 +17,35 @@ TCPSender::TCPSender(const size_t capacity, const uint16_t retx_timeout, const s
     : _isn(fixed_isn.value_or(WrappingInt32{random_device()()}))
     , _initial_retransmission_timeout{retx_timeout}
     , _current_retransmission_timeout{retx_timeout}
-    , _stream(capacity) {}
+    , _stream(capacity)
+    , _base_capacity(capacity)
+    , _max_capacity(capacity) {}
+
+//! \param[in] config the connection's configuration (send capacity, timeout, ISN and SACK preference)
+TCPSender::TCPSender(const TCPConfig &config) : TCPSender(config.send_capacity, config.rt_timeout, config.fixed_isn) {
+    _sack_offered = config.sack;
+    _rack_tlp_enabled = config.rack_tlp;
+    _pacing_enabled = config.pacing;
+    _pacing_rate_cap = config.pacing_rate_cap;
+    _nagle = config.nagle;
+    _corked = config.cork;
+    _gso_enabled = config.gso;
+    _repacketize_enabled = config.repacketize;
+    _window_scale_offered = config.window_scale;
+    _rcv_window_shift = config.window_shift();
+    _timestamps_offered = config.timestamps;
+    _mss_offered = config.mss;
+    _plpmtud_enabled = config.plpmtud;
+    _mss = _plpmtud_enabled ? std::min<size_t>(config.mss, TCPConfig::MAX_PAYLOAD_SIZE) : config.mss;
+    _mtu_search_low = _mss;
+    _mtu_search_high = size_t{config.mss} + 1;
+    _fastopen_cookie = config.fastopen_cookie;
+    _ecn_offered = config.ecn;
+    _dctcp = config.dctcp;
+    _autotune = config.autotune;
+    _max_capacity = std::max(config.max_send_capacity, _base_capacity);
+    _memory = TCPMemoryShare{config.memory_budget};
+}
 
 uint64_t TCPSender::bytes_in_flight() const { return next_seqno_absolute() - _bytes_acked; }
 
@@ -26,24 +57,68 @@ void TCPSender::_send_segment(bool syn, bool fin) {
     seg.header().seqno = next_seqno();
     seg.header().syn = syn;
     seg.header().fin = fin;
+    seg.header().sack_permitted = syn && _sack_offered;
+    (syn) && (seg.header().mss = _mss_offered);
+    (syn) && (seg.header().fastopen_cookie = _fastopen_cookie);
+    // An ECN-setup SYN carries ECE and CWR; the SYN-ACK that agrees carries only ECE (RFC 3168 section 6.1.1).
+    seg.header().ece = syn && _ecn_offered && (!_peer_syn_seen || _peer_ecn);
+    seg.header().cwr = syn && _ecn_offered && !_peer_syn_seen;
+    if (syn && _window_scale_offered && (!_peer_syn_seen || _peer_window_shift.has_value()))
+        seg.header().window_scale = _rcv_window_shift;
+    if (syn ? _timestamps_offered && (!_peer_syn_seen || _peer_timestamps) : timestamps_enabled())
+        seg.header().timestamps = TCPTimestamps{static_cast<uint32_t>(_now), 0};
 
-    // Setting the payload. It's important to note that the SYN segment isn't used to carry payload in this context.
-    // While the initial SYN segment might theoretically include data from the connection initiator (as per RFC 793,
-    // which outlines TCP specifications), TCP doesn't allow this data to be passed to the application until the
-    // three-way handshake is complete. Yet, TCP Fast Open (TFO) does support carrying data in the SYN segment.
-    if (!syn) {
-        size_t remain_space = static_cast<size_t>(_window_right - _next_seqno);
+    // Setting the payload. The SYN segment usually carries no payload: while the initial SYN segment might
+    // theoretically include data from the connection initiator (as per RFC 793, which outlines TCP specifications),
+    // TCP doesn't allow this data to be passed to the application until the three-way handshake is complete. Yet,
+    // TCP Fast Open (TFO) does support carrying data in the SYN segment, which we do when we hold a cookie. Before
+    // the handshake the peer's window is unknown, so the SYN carries at most one MSS.
+    if (!syn || (_fastopen_cookie.has_value() && !_fastopen_cookie.value().empty())) {
+        size_t remain_space = syn ? _mss : static_cast<size_t>(_window_right - _next_seqno);
+        // A segment may overshoot the congestion window by less than one MSS, but a super-segment no further.
+        if (!syn && ecn_enabled() && !_in_recovery)
+            remain_space = std::min(remain_space, std::max(_ecn_cwnd - std::min(_ecn_cwnd, bytes_in_flight()), _mss));
         size_t remain_bytes = stream_in().buffer_size();
-        size_t payload_len = _should_probe() ? 1 : std::min({TCPConfig::MAX_PAYLOAD_SIZE, remain_space, remain_bytes});
-        seg.payload() = stream_in().read(payload_len);
+        size_t payload_len = _should_probe() ? 1 : std::min({_max_payload_size(), remain_space, remain_bytes});
+
+        // A path MTU probe is a larger segment of new data, sent only when there is enough of it to fill one.
+        const size_t probe_size = syn || _should_probe() ? 0 : _next_mtu_probe_size();
+        if (probe_size > 0 && remain_space >= probe_size && remain_bytes >= probe_size) {
+            payload_len = probe_size;
+            _mtu_probe_seqno = _next_seqno;
+            _mtu_probe_size = probe_size;
+        }
+        // Bytes copied out of several writes are checksummed as they are copied.
+        seg.payload() = stream_in().read_buffer_and_checksum(payload_len);
+        payload_len = seg.payload().size();
+
+        // A super-segment is tracked as one unit and split into MSS-sized wire segments by TCPSegment::serialize.
+        (_gso_enabled && payload_len > _mss) && (seg.gso_size() = _mss);
+
+        // PSH marks the segment that carries the last byte written before a flush.
+        seg.header().psh = _next_seqno < _push_point && _push_point <= _next_seqno + payload_len;
+
+        // New data is sent ECN-capable; the first after a window reduction reports it with CWR. A SYN's CWR (on
+        // data sent with Fast Open) belongs to ECN setup, above.
+        seg.ect() = ecn_enabled() && payload_len > 0;
+        if (!syn) {
+            seg.header().cwr = _send_cwr && payload_len > 0;
+            (seg.header().cwr) && (_send_cwr = false);
+        }
     }
 
     _segments_out.push(seg);
-    _segments_outstanding.push_back(seg);
+    _segments_outstanding.push_back({seg, _next_seqno, _now});
+    _segments_sent += seg.wire_segment_count();
+    _bytes_sent += seg.payload().size();
 
     // Update the seqno and timer switch.
     _next_seqno += seg.length_in_sequence_space();
     (!_is_timer_started) && (_is_timer_started = true);
+
+    // A new transmission of data (re)starts the tail loss probe timer.
+    if (!syn)
+        _arm_tlp();
 }
 
 void TCPSender::_handle_closed() {
@@ -62,10 +137,29 @@ void TCPSender::_handle_transmission() {
         (is_fin) && (_state = FIN_SENT);
     }
 
+    // The pipe is counted once; each new segment then adds to it.
+    uint64_t pipe = _in_recovery ? _pipe() : 0;
     while (_next_seqno < _window_right) {
         if (!stream_in().input_ended() && stream_in().buffer_size() == 0)
             break;
 
+        // Nagle and cork hold a partial segment back until more data arrives.
+        if (_should_hold())
+            break;
+
+        // During loss recovery new data is also limited by the congestion window (RFC 6675 NextSeg rule 2).
+        if (_in_recovery && pipe >= _cwnd)
+            break;
+
+        // With ECN, new data is limited by the congestion window that marks shrink.
+        if (ecn_enabled() && !_in_recovery && bytes_in_flight() >= _ecn_cwnd)
+            break;
+
+        // When pacing, each segment waits for its departure time; tick() sends it once that arrives.
+        const std::optional<uint64_t> rate = pacing_rate();
+        if (rate.has_value() && _now * 1000 < _next_departure_us)
+            break;
+
         // SYN hasn't been sent, which is an error in this state.
         if (next_seqno_absolute() == 0) {
             _state = SERROR;
@@ -74,6 +168,18 @@ void TCPSender::_handle_transmission() {
 
         bool is_fin = _is_fin();
         _send_segment(false, is_fin);
+        pipe += _segments_outstanding.back().segment.length_in_sequence_space();
+
+        // The next departure is one segment's serialization time at the pacing rate after this one. A departure that
+        // is late only because of timer granularity keeps its schedule; after an idle period the schedule restarts now.
+        if (rate.has_value()) {
+            const uint64_t len = _segments_outstanding.back().segment.length_in_sequence_space();
+            const uint64_t interval = len * 1000000 / rate.value();
+            const uint64_t now_us = _now * 1000;
+            const bool on_schedule = now_us - std::min(now_us, _next_departure_us) < interval;
+            _next_departure_us = (on_schedule ? _next_departure_us : now_us) + interval;
+        }
+
         if (is_fin) {
             _state = FIN_SENT;
             break;
@@ -81,6 +187,57 @@ void TCPSender::_handle_transmission() {
     }
 }
 
+bool TCPSender::_has_data_to_send() const {
+    if (_state != SYN_ACKED || _next_seqno >= _window_right)
+        return false;
+    if (_should_hold())
+        return false;
+    if (ecn_enabled() && !_in_recovery && bytes_in_flight() >= _ecn_cwnd)
+        return false;
+    return !stream_in().buffer_empty() || (stream_in().input_ended() && _next_seqno < stream_in().bytes_written() + 2);
+}
+
+//! \details A segment that would be shorter than the MSS only because too little data is buffered waits
+//! while corked, or under Nagle's algorithm (RFC 896) while earlier data is unacknowledged. Data up to the push
+//! point, the FIN, and segments cut short by the peer's window are never held.
+bool TCPSender::_should_hold() const {
+    if (!_nagle && !_corked)
+        return false;
+
+    const uint64_t buffered = stream_in().buffer_size();
+    if (buffered >= _mss || _window_right - std::min(_window_right, _next_seqno) < buffered)
+        return false;
+    if (stream_in().input_ended() || _next_seqno < _push_point)
+        return false;
+
+    return _corked || bytes_in_flight() > 0;
+}
+
+std::optional<uint64_t> TCPSender::pacing_rate() const {
+    if (!_pacing_enabled)
+        return std::nullopt;
+
+    std::optional<uint64_t> rate{};
+    if (_rtt_measured) {
+        // Spread the usable window over one smoothed RTT.
+        uint64_t window = _window_right - std::min(_window_right, _bytes_acked);
+        (_in_recovery) && (window = std::min(window, _cwnd));
+        window = std::max<uint64_t>(window, _mss);
+        rate = window * PACING_GAIN_PERCENT * 10 / std::max<uint64_t>(_srtt, 1);
+    }
+    if (_pacing_rate_cap > 0)
+        rate = std::min(rate.value_or(_pacing_rate_cap), _pacing_rate_cap);
+    if (rate.has_value() && rate.value() == 0)
+        rate = 1;
+    return rate;
+}
+
+std::optional<uint64_t> TCPSender::next_departure() const {
+    if (!pacing_rate().has_value() || !_has_data_to_send())
+        return std::nullopt;
+    return std::max(_now, (_next_departure_us + 999) / 1000);
+}
+
 bool TCPSender::_should_probe() {
     // When the receiver acknowledges with a window size of 0, it indicates that the receiver's buffer is full and
     // cannot accept more segments at the moment. To determine when the receiver has available space again, we continue
@@ -96,10 +253,27 @@ bool TCPSender::_is_probing() {
 bool TCPSender::_is_fin() {
     // A subtle point here: Don't send FIN by itself if the window is full
     // For instance, consider the bytes "ABC<EOF>" and a window size of 3. This segment won't be marked as FIN even it
-    // statifies the first two conditions below.
+    // statifies the first two conditions below. Likewise, the FIN waits for the last segment when the remaining bytes
+    // need more than one.
     return stream_in().input_ended() &&
            next_seqno_absolute() + stream_in().buffer_size() == stream_in().bytes_written() + 1 &&
-           next_seqno_absolute() + stream_in().buffer_size() < _window_right;
+           next_seqno_absolute() + stream_in().buffer_size() < _window_right &&
+           stream_in().buffer_size() <= _max_payload_size();
+}
+
+size_t TCPSender::_max_payload_size() const {
+    return _gso_enabled ? std::max(_mss, TCPConfig::MAX_GSO_PAYLOAD_SIZE / _mss * _mss) : _mss;
+}
+
+//! \returns the payload size of the next path MTU probe, or 0 if none should be sent now
+//! \details The search is a bisection between the largest size that got through and the smallest that did not
+//! (RFC 4821 section 7.5). One probe is in flight at a time, and none during loss recovery or with GSO.
+size_t TCPSender::_next_mtu_probe_size() const {
+    if (!_plpmtud_enabled || _gso_enabled || _in_recovery || _mtu_probe_seqno.has_value())
+        return 0;
+    if (_mtu_search_high - _mtu_search_low <= PLPMTUD_SEARCH_DONE)
+        return 0;
+    return (_mtu_search_low + _mtu_search_high) / 2;
 }
 
 void TCPSender::fill_window() {
@@ -113,56 +287,722 @@ void TCPSender::fill_window() {
 //! \param ackno The remote receiver's ackno (acknowledgment number)
 //! \param window_size The remote receiver's advertised window size
 void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_size) {
+    _ack_received(ackno, window_size, {}, std::nullopt, false);
+}
+
+//! \param header The header of a segment received from the peer
+void TCPSender::ack_received(const TCPHeader &header) {
+    if (header.syn) {
+        _peer_sack_permitted = header.sack_permitted;
+        _peer_syn_seen = true;
+        _peer_window_shift = header.window_scale;
+        if (_window_scale_offered && _peer_window_shift.has_value())
+            _snd_window_shift = std::min(_peer_window_shift.value(), TCPHeader::MAX_WINDOW_SHIFT);
+        _peer_timestamps = header.timestamps.has_value();
+        if (header.fastopen_cookie.has_value() && !header.fastopen_cookie.value().empty())
+            _peer_fastopen_cookie = header.fastopen_cookie;
+        if (header.mss.has_value()) {
+            const size_t peer_mss = std::max<size_t>(header.mss.value(), 1);
+            _mss = std::min(_mss, peer_mss);
+            _mtu_search_low = std::min(_mtu_search_low, peer_mss);
+            _mtu_search_high = std::min(_mtu_search_high, peer_mss + 1);
+        }
+        // A SYN-ACK agrees to ECN with ECE alone; a SYN asks for it with ECE and CWR (RFC 3168 section 6.1.1).
+        _peer_ecn = header.ece && (header.ack ? !header.cwr : header.cwr);
+        _ecn_cwnd = INITIAL_WINDOW_SEGMENTS * _mss;
+        _dctcp_window_end = _next_seqno;
+    }
+
+    // The window on a SYN is never scaled (RFC 7323 section 2.2).
+    const uint64_t window = header.syn ? header.win : uint64_t{header.win} << _snd_window_shift;
+    std::optional<uint32_t> tsecr{};
+    if (timestamps_enabled() && header.timestamps.has_value())
+        tsecr = header.timestamps.value().tsecr;
+    // ECE on a SYN negotiates ECN rather than echoing a mark.
+    if (header.ack)
+        _ack_received(header.ackno, window, header.sack_blocks, tsecr, header.ece && !header.syn);
+}
+
+void TCPSender::_ack_received(const WrappingInt32 ackno,
+                              const uint64_t window_size,
+                              const TCPHeader::SACKBlocks &sack_blocks,
+                              const std::optional<uint32_t> tsecr,
+                              const bool ece) {
+    const uint64_t abs_ackno = unwrap(ackno, _isn, _bytes_acked);
+
     // Defensive programming: an invalid ackno will simply be abandoned.
-    if (unwrap(ackno, _isn, _bytes_acked) > next_seqno_absolute())
+    if (abs_ackno > next_seqno_absolute())
         return;
 
+    const bool newly_sacked = sack_enabled() && _update_scoreboard(sack_blocks);
+    const bool dup_ack = abs_ackno == _bytes_acked && !_segments_outstanding.empty() && newly_sacked;
+
     // Only reset the timer if a new segment has been acked.
-    if (unwrap(ackno, _isn, _bytes_acked) > _bytes_acked) {
-        _bytes_acked = unwrap(ackno, _isn, _bytes_acked);
+    const bool new_data_acked = abs_ackno > _bytes_acked;
+    const uint64_t newly_acked = abs_ackno - std::min(abs_ackno, std::max<uint64_t>(_bytes_acked, 1));  // not the SYN
+    if (new_data_acked) {
+        _bytes_acked = abs_ackno;
         _timer_million_seconds = 0;
         _current_retransmission_timeout = _initial_retransmission_timeout;
         _retransmission_times = 0;
+        _dup_acks = 0;
+    }
+
+    // Take at most one RTT sample per ACK, from the newest segment it covers, and only if that segment was
+    // never retransmitted (Karn's algorithm). With timestamps, the echoed TSval dates the very transmission
+    // that was acknowledged, so every ACK that acknowledges or SACKs new data gives a sample (RFC 7323 section 4).
+    std::optional<uint64_t> rtt{};
+    auto it = _segments_outstanding.begin();
+    while (it != _segments_outstanding.end() && (*it).abs_end() <= abs_ackno) {
+        ((*it).segment.header().syn) && (_state = SYN_ACKED);
+        ((*it).segment.header().fin) && (_state = FIN_ACKED);
+        rtt = (*it).transmissions == 1 ? std::optional<uint64_t>{_now - (*it).sent_time} : std::nullopt;
+        if (!(*it).sacked)
+            _rack_update(*it);
+        it++;
     }
+    _segments_outstanding.erase(_segments_outstanding.begin(), it);
 
-    for (auto it = _segments_outstanding.begin(); it < _segments_outstanding.end(); it++) {
-        uint64_t abs_ackno = unwrap(ackno, _isn, _bytes_acked);
-        uint64_t abs_outstanding_seg_right =
-            unwrap((*it).header().seqno + (*it).length_in_sequence_space(), _isn, _bytes_acked);
-        if (abs_outstanding_seg_right <= abs_ackno) {
-            ((*it).header().syn) && (_state = SYN_ACKED);
-            ((*it).header().fin) && (_state = FIN_ACKED);
-            _segments_outstanding.erase(it);
+    // A server that did not accept the data on our SYN acknowledges only the SYN: send the data again straight
+    // away, as ordinary segments no larger than the MSS its SYN-ACK announced (RFC 7413 section 4.2.2).
+    if (!_segments_outstanding.empty() && _segments_outstanding.front().segment.header().syn &&
+        abs_ackno == _segments_outstanding.front().abs_seqno + 1) {
+        OutstandingSegment &front = _segments_outstanding.front();
+        TCPHeader &header = front.segment.header();
+        header.syn = false;
+        header.seqno = header.seqno + 1;
+        header.mss.reset();
+        header.sack_permitted = false;
+        header.window_scale.reset();
+        header.fastopen_cookie.reset();
+        header.ece = header.cwr = false;
+        if (!timestamps_enabled())
+            header.timestamps.reset();
+        front.abs_seqno++;
+        _state = SYN_ACKED;
+        const uint64_t syn_data_end = front.abs_end();
+        _split(0);
+        for (size_t i = 0; i < _segments_outstanding.size() && _segments_outstanding[i].abs_seqno < syn_data_end; i++)
+            _retransmit(_segments_outstanding[i]);
+    }
+    const uint32_t echoed_age = static_cast<uint32_t>(_now) - tsecr.value_or(0);
+    if (tsecr.has_value() && (new_data_acked || newly_sacked) && echoed_age <= INT32_MAX)
+        rtt = echoed_age;
+    if (rtt.has_value())
+        _rtt_sample(rtt.value());
+
+    // A delivered probe shows that the path carries segments of its size.
+    if (_mtu_probe_seqno.has_value()) {
+        bool probe_delivered = _bytes_acked >= _mtu_probe_seqno.value() + _mtu_probe_size;
+        for (const auto &outstanding : _segments_outstanding)
+            probe_delivered |= outstanding.sacked && outstanding.abs_seqno == _mtu_probe_seqno.value();
+        if (probe_delivered) {
+            _mss = _mtu_search_low = _mtu_probe_size;
+            _mtu_probe_seqno.reset();
         }
     }
 
+    // Drop the acknowledged wire segments of a super-segment, so that a retransmission resends only the rest.
+    if (!_segments_outstanding.empty() && _segments_outstanding.front().segment.gso_size() > 0) {
+        OutstandingSegment &front = _segments_outstanding.front();
+        const size_t gso_size = front.segment.gso_size();
+        const uint64_t acked = (abs_ackno - std::min(abs_ackno, front.abs_seqno)) / gso_size * gso_size;
+        if (acked > 0 && acked < front.segment.payload().size()) {
+            front.segment.payload().remove_prefix(acked);
+            front.segment.header().seqno = front.segment.header().seqno + acked;
+            front.abs_seqno += acked;
+        }
+    }
+
+    if (_tlp_end_seq.has_value() && _bytes_acked >= _tlp_end_seq.value())
+        _tlp_end_seq.reset();
+
     // Reset the timer. Specially, if all of the outstanding segments have been acknowledged, stop the timer.
     if (!_segments_outstanding.size())
         _is_timer_started = false;
 
     // The TCPSender should fill the window again if new space has opened up.
-    _window_right = _bytes_acked + static_cast<uint64_t>(window_size);
+    _window_right = _bytes_acked + window_size;
+
+    _ecn_ack(newly_acked, ece);
+    _autotune_capacity();
+
+    if (_rack_tlp_enabled && sack_enabled())
+        _rack_detect_loss();
+
+    if (sack_enabled())
+        _loss_recovery(dup_ack);
 
     if (_window_right > _next_seqno)
         fill_window();
+
+    if (new_data_acked || _segments_outstanding.empty())
+        _arm_tlp();
+}
+
+//! \param[in] acked the number of bytes newly acknowledged by an ACK
+//! \param[in] ece whether the ACK carried ECN-Echo
+//! \details The window is reduced at most once per window of data: by half with classic ECN, as for a loss
+//! (RFC 3168 section 6.1.2), or by alpha / 2 with DCTCP, where alpha tracks the fraction of bytes marked
+//! (RFC 8257 section 3.3). Otherwise it grows as in RFC 5681.
+void TCPSender::_ecn_ack(const uint64_t acked, const bool ece) {
+    if (!ecn_enabled())
+        return;
+
+    if (_dctcp) {
+        _dctcp_bytes_acked += acked;
+        (ece) && (_dctcp_bytes_marked += acked);
+        if (_bytes_acked > _dctcp_window_end) {
+            const uint64_t fraction =
+                _dctcp_bytes_acked > 0 ? _dctcp_bytes_marked * DCTCP_ALPHA_ONE / _dctcp_bytes_acked : 0;
+            _dctcp_alpha = _dctcp_alpha - (_dctcp_alpha >> DCTCP_G_SHIFT) + (fraction >> DCTCP_G_SHIFT);
+            _dctcp_bytes_acked = _dctcp_bytes_marked = 0;
+            _dctcp_window_end = _next_seqno;
+        }
+    }
+
+    if (ece && _bytes_acked > _ecn_recover && !_in_recovery) {
+        const uint64_t reduced = _dctcp ? _ecn_cwnd - _ecn_cwnd * _dctcp_alpha / (2 * DCTCP_ALPHA_ONE)
+                                        : bytes_in_flight() / 2;
+        _ecn_cwnd = _ssthresh = std::max(reduced, uint64_t{2 * _mss});
+        _ecn_recover = _next_seqno;
+        _send_cwr = true;
+    } else if (acked > 0) {
+        const bool slow_start = _ecn_cwnd < _ssthresh;
+        _ecn_cwnd += slow_start ? std::min<uint64_t>(acked, _mss) : std::max<uint64_t>(_mss * _mss / _ecn_cwnd, 1);
+    }
+}
+
+//! \details The writer should be able to keep a window in flight and another queued behind it, so the outbound
+//! stream grows to twice the window the sender may use: the peer's, or the congestion window if it is smaller
+//! (as in Linux's tcp_sndbuf_expand). It does not shrink, so bytes already written are never left beyond it.
+void TCPSender::_autotune_capacity() {
+    if (!_autotune)
+        return;
+    uint64_t window = _window_right - std::min(_window_right, _bytes_acked);
+    (_in_recovery) && (window = std::min(window, _cwnd));
+    (ecn_enabled()) && (window = std::min(window, _ecn_cwnd));
+
+    const size_t target = std::min<uint64_t>(std::max<uint64_t>(2 * window, _base_capacity), _max_capacity);
+    if (target > _stream.capacity())
+        _stream.set_capacity(_base_capacity + _memory.resize(target - _base_capacity));
+}
+
+//! \param sack_blocks the SACK blocks carried by an incoming segment
+//! \returns whether any outstanding segment became SACKed
+//! \note A segment is only marked once a single block covers it entirely. A GSO super-segment that a block
+//! covers only part of is first split into its wire segments, which are tracked separately from then on.
+bool TCPSender::_update_scoreboard(const TCPHeader::SACKBlocks &sack_blocks) {
+    bool newly_sacked = false;
+    for (const auto &block : sack_blocks) {
+        const uint64_t left = unwrap(block.left, _isn, _bytes_acked);
+        const uint64_t right = unwrap(block.right, _isn, _bytes_acked);
+        // Ignore blocks that are empty, already cumulatively acknowledged, or beyond what we have sent.
+        if (left >= right || right <= _bytes_acked || right > _next_seqno)
+            continue;
+        for (size_t i = 0; i < _segments_outstanding.size(); i++) {
+            const OutstandingSegment &candidate = _segments_outstanding[i];
+            const bool covered = candidate.abs_seqno >= left && candidate.abs_end() <= right;
+            const bool overlaps = candidate.abs_seqno < right && candidate.abs_end() > left;
+            const size_t gso_size = candidate.segment.gso_size();
+            const bool bundled = gso_size > 0 && candidate.segment.payload().size() > gso_size;
+            if (!candidate.sacked && bundled && overlaps && !covered)
+                _split(i, gso_size);
+
+            OutstandingSegment &outstanding = _segments_outstanding[i];
+            if (!outstanding.sacked && outstanding.abs_seqno >= left && outstanding.abs_end() <= right) {
+                outstanding.sacked = true;
+                newly_sacked = true;
+                _rack_update(outstanding);
+            }
+        }
+    }
+    return newly_sacked;
+}
+
+//! \param index position of an unSACKed segment in the scoreboard
+//! \returns whether the segment is deemed lost (RFC 6675 IsLost): either DUP_THRESH segments or more than
+//! (DUP_THRESH - 1) * SMSS bytes above it have been SACKed, or RACK has marked it lost
+bool TCPSender::_is_lost(const size_t index) const {
+    if (_segments_outstanding[index].lost)
+        return true;
+
+    unsigned int sacked_segments = 0;
+    uint64_t sacked_bytes = 0;
+    for (size_t i = index + 1; i < _segments_outstanding.size(); i++) {
+        if (_segments_outstanding[i].sacked) {
+            sacked_segments++;
+            sacked_bytes += _segments_outstanding[i].segment.length_in_sequence_space();
+        }
+    }
+    return sacked_segments >= DUP_THRESH || sacked_bytes > (DUP_THRESH - 1) * _mss;
+}
+
+//! \returns the pipe (see _pipe()), after marking in `_sack_lost` which segments the SACKs above them show lost
+//! and recording each segment's share of the pipe in `_pipe_shares`, in one pass over the scoreboard
+uint64_t TCPSender::_scan_scoreboard() {
+    const size_t count = _segments_outstanding.size();
+    _sack_lost.assign(count, false);
+    _pipe_shares.assign(count, 0);
+    uint64_t pipe = 0;
+    unsigned int sacked_segments = 0;
+    uint64_t sacked_bytes = 0;
+    for (size_t i = count; i-- > 0;) {
+        const OutstandingSegment &outstanding = _segments_outstanding[i];
+        if (outstanding.sacked) {
+            sacked_segments++;
+            sacked_bytes += outstanding.segment.length_in_sequence_space();
+            continue;
+        }
+        _sack_lost[i] = sacked_segments >= DUP_THRESH || sacked_bytes > (DUP_THRESH - 1) * _mss;
+        _pipe_shares[i] = _pipe_share(i);
+        pipe += _pipe_shares[i];
+    }
+    return pipe;
+}
+
+//! \param index position of an unSACKed segment in the scoreboard, as of the last _scan_scoreboard()
+//! \returns the bytes of the segment in the pipe: its transmission unless it is deemed lost, and its
+//! retransmission if there was one
+uint64_t TCPSender::_pipe_share(const size_t index) const {
+    const OutstandingSegment &outstanding = _segments_outstanding[index];
+    const uint64_t len = outstanding.segment.length_in_sequence_space();
+    return (outstanding.lost || _sack_lost[index] ? 0 : len) + (outstanding.retransmitted ? len : 0);
+}
+
+//! \param index position of an unSACKed segment in the scoreboard
+//! \param[in,out] pipe the pipe, as _scan_scoreboard() returned it and this method has kept it since
+//! \details Repacketizing may split the segment into pieces that follow it, or merge the unSACKed segments after
+//! it into it. Pieces are lost exactly when the segment was, since the same SACKed segments are above them.
+void TCPSender::_recovery_retransmit(const size_t index, uint64_t &pipe) {
+    const size_t before = _segments_outstanding.size();
+    const bool sack_lost = _sack_lost[index];
+    _retransmit(_repacketize(index));
+    const size_t after = _segments_outstanding.size();
+
+    const size_t replaced = before > after ? before - after + 1 : 1;
+    const size_t pieces = after > before ? after - before + 1 : 1;
+    const auto shares = _pipe_shares.begin() + index;
+    pipe -= std::accumulate(shares, shares + replaced, uint64_t{0});
+    if (replaced != pieces) {
+        _sack_lost.erase(_sack_lost.begin() + index, _sack_lost.begin() + index + replaced);
+        _sack_lost.insert(_sack_lost.begin() + index, pieces, sack_lost);
+        _pipe_shares.erase(shares, shares + replaced);
+        _pipe_shares.insert(_pipe_shares.begin() + index, pieces, 0);
+    }
+    for (size_t i = index; i < index + pieces; i++) {
+        _pipe_shares[i] = _pipe_share(i);
+        pipe += _pipe_shares[i];
+    }
+}
+
+//! \returns the sender's estimate of the bytes still in the network (RFC 6675 SetPipe)
+uint64_t TCPSender::_pipe() const {
+    uint64_t pipe = 0;
+    unsigned int sacked_segments = 0;
+    uint64_t sacked_bytes = 0;
+
+    // Walk from the highest sequence number down so that IsLost() can be answered as we go.
+    for (auto it = _segments_outstanding.rbegin(); it != _segments_outstanding.rend(); it++) {
+        const uint64_t len = (*it).segment.length_in_sequence_space();
+        if ((*it).sacked) {
+            sacked_segments++;
+            sacked_bytes += len;
+            continue;
+        }
+        const bool lost = (*it).lost || sacked_segments >= DUP_THRESH ||
+                          sacked_bytes > (DUP_THRESH - 1) * _mss;
+        if (!lost)
+            pipe += len;
+        if ((*it).retransmitted)
+            pipe += len;
+    }
+    return pipe;
+}
+
+//! \param dup_ack whether the ACK being processed was a duplicate that newly SACKed data
+void TCPSender::_loss_recovery(const bool dup_ack) {
+    // Recovery ends once everything outstanding when it began has been cumulatively acknowledged.
+    if (_in_recovery && _bytes_acked >= _recovery_point) {
+        _in_recovery = false;
+        _dup_acks = 0;
+    }
+
+    bool entering = false;
+    if (!_in_recovery) {
+        if (dup_ack)
+            _dup_acks++;
+        const bool rack_lost = std::any_of(_segments_outstanding.begin(),
+                                           _segments_outstanding.end(),
+                                           [](const OutstandingSegment &outstanding) { return outstanding.lost; });
+        if (_segments_outstanding.empty() || (_dup_acks < DUP_THRESH && !_is_lost(0) && !rack_lost))
+            return;
+
+        // Enter recovery: halve the flight (RFC 5681) and repair the first hole straight away.
+        entering = true;
+        _in_recovery = true;
+        _recovery_point = _next_seqno;
+        _cwnd = std::max(bytes_in_flight() / 2, uint64_t{2 * _mss});
+        (ecn_enabled()) && (_ecn_cwnd = _ssthresh = _cwnd);
+        _tlp_deadline.reset();
+        for (auto &outstanding : _segments_outstanding)
+            outstanding.retransmitted = false;
+    }
+
+    // One pass over the scoreboard finds the lost segments and the pipe; retransmissions then keep both up to date
+    // rather than scanning the scoreboard again for each segment.
+    uint64_t pipe = _scan_scoreboard();
+    if (entering && !_segments_outstanding.front().sacked)
+        _recovery_retransmit(0, pipe);
+
+    // NextSeg rule 1: retransmit unSACKed holes that are deemed lost, lowest first, while the pipe allows.
+    for (size_t i = 0; i < _segments_outstanding.size() && pipe < _cwnd; i++) {
+        const OutstandingSegment &outstanding = _segments_outstanding[i];
+        if (!outstanding.sacked && !outstanding.retransmitted && (outstanding.lost || _sack_lost[i]))
+            _recovery_retransmit(i, pipe);
+    }
+
+    // NextSeg rule 3: with no new data to send, retransmit unSACKed data below the highest SACKed segment.
+    const bool can_send_new = !stream_in().buffer_empty() && _next_seqno < _window_right;
+    if (can_send_new)
+        return;
+    size_t highest_sacked = _segments_outstanding.size();
+    for (size_t i = 0; i < _segments_outstanding.size(); i++)
+        (_segments_outstanding[i].sacked) && (highest_sacked = i);
+    for (size_t i = 0; i < highest_sacked && pipe < _cwnd; i++) {
+        const OutstandingSegment &outstanding = _segments_outstanding[i];
+        if (outstanding.sacked || outstanding.retransmitted)
+            continue;
+        // Splitting or merging the segment moves the highest SACKed one.
+        const size_t before = _segments_outstanding.size();
+        _recovery_retransmit(i, pipe);
+        highest_sacked = highest_sacked + _segments_outstanding.size() - before;
+    }
+}
+
+//! \param[in] index the outstanding segment about to be retransmitted
+//! \returns the segment, fitted to the current MSS: split if it is larger, or merged with the unSACKed segments
+//! after it while the result fits in one MSS
+//! \details A segment only becomes larger than the MSS when it was a path MTU probe, which is deemed lost once
+//! it needs retransmitting, or when black hole detection has since lowered the MSS. Small writes that are still
+//! in flight go out again as a few full segments instead of one per retransmission. Segments carrying SYN,
+//! SACKed segments and GSO super-segments are never merged.
+OutstandingSegment &TCPSender::_repacketize(const size_t index) {
+    if (_mtu_probe_seqno.has_value() && _mtu_probe_seqno.value() == _segments_outstanding[index].abs_seqno) {
+        _mtu_search_high = std::min(_mtu_search_high, _mtu_probe_size);
+        _mtu_probe_seqno.reset();
+    }
+    _split(index);
+
+    OutstandingSegment &first = _segments_outstanding[index];
+    const size_t mss = _mss;
+    const auto mergeable = [mss](const OutstandingSegment &outstanding) {
+        return !outstanding.sacked && !outstanding.segment.header().syn && outstanding.segment.payload().size() < mss;
+    };
+    if (!_repacketize_enabled || !mergeable(first) || first.segment.header().fin)
+        return first;
+
+    size_t end = index + 1;
+    size_t payload_size = first.segment.payload().size();
+    while (end < _segments_outstanding.size() && mergeable(_segments_outstanding[end]) &&
+           payload_size + _segments_outstanding[end].segment.payload().size() <= _mss) {
+        payload_size += _segments_outstanding[end].segment.payload().size();
+        if (_segments_outstanding[end++].segment.header().fin)
+            break;
+    }
+    if (end == index + 1)
+        return first;
+
+    // The payloads are checksummed as they are copied together.
+    std::string payload(payload_size, '\0');
+    InternetChecksum check;
+    for (size_t i = index, copied = 0; i < end; i++) {
+        const OutstandingSegment &merged = _segments_outstanding[i];
+        check.copy_and_add(payload.data() + copied, merged.segment.payload().str());
+        copied += merged.segment.payload().size();
+        first.segment.header().fin |= merged.segment.header().fin;
+        first.segment.header().psh |= merged.segment.header().psh;
+        first.transmissions = std::max(first.transmissions, merged.transmissions);
+        first.retransmitted |= merged.retransmitted;
+        first.lost |= merged.lost;
+    }
+    first.segment.payload() = Buffer{std::move(payload), check.partial()};
+    _segments_outstanding.erase(_segments_outstanding.begin() + index + 1, _segments_outstanding.begin() + end);
+    return _segments_outstanding[index];
+}
+
+//! \param[in] index an outstanding segment whose payload may exceed the current MSS
+//! \details A GSO super-segment gives up just its first wire segment, so that a retransmission is one MSS, as it
+//! is without GSO; the rest stays one super-segment.
+void TCPSender::_split(const size_t index) {
+    TCPSegment &segment = _segments_outstanding[index].segment;
+    if (segment.gso_size() > _mss)
+        segment.gso_size() = _mss;
+    if (segment.gso_size() > 0) {
+        if (segment.wire_segment_count() > 1)
+            _split_at(index, segment.gso_size());
+        return;
+    }
+    if (segment.payload().size() > _mss)
+        _split(index, _mss);
+}
+
+//! \param[in] index an outstanding segment
+//! \param[in] offset where to divide its payload in two; each part stays a super-segment if it is still larger
+//! than one wire segment
+void TCPSender::_split_at(const size_t index, const size_t offset) {
+    OutstandingSegment tail = _segments_outstanding[index];
+    TCPSegment &head = _segments_outstanding[index].segment;
+    head.payload().remove_suffix(head.payload().size() - offset);
+    head.header().fin = head.header().psh = false;
+    tail.segment.payload().remove_prefix(offset);
+    tail.segment.header().seqno = head.header().seqno + offset;
+    tail.segment.header().syn = false;
+    tail.abs_seqno += offset;
+    for (TCPSegment *part : {&head, &tail.segment})
+        (part->payload().size() <= part->gso_size()) && (part->gso_size() = 0);
+    _segments_outstanding.insert(_segments_outstanding.begin() + index + 1, std::move(tail));
+}
+
+//! \param[in] index an outstanding segment
+//! \param[in] piece_size the payload size of each piece but the last, which become ordinary segments
+void TCPSender::_split(const size_t index, const size_t piece_size) {
+    const TCPSegment &segment = _segments_outstanding[index].segment;
+    const size_t size = segment.payload().size();
+
+    // Each piece is a view into the original payload.
+    std::vector<OutstandingSegment> pieces{};
+    for (size_t offset = 0; offset < size; offset += piece_size) {
+        const size_t len = std::min(piece_size, size - offset);
+        OutstandingSegment piece = _segments_outstanding[index];
+        piece.segment.gso_size() = 0;
+        piece.segment.payload().remove_prefix(offset);
+        piece.segment.payload().remove_suffix(size - offset - len);
+        piece.segment.header().seqno = segment.header().seqno + offset;
+        piece.segment.header().syn &= offset == 0;
+        piece.segment.header().fin &= offset + len == size;
+        piece.segment.header().psh &= offset + len == size;
+        piece.abs_seqno += offset;
+        pieces.push_back(std::move(piece));
+    }
+    _segments_outstanding.erase(_segments_outstanding.begin() + index);
+    _segments_outstanding.insert(_segments_outstanding.begin() + index,
+                                 std::make_move_iterator(pieces.begin()),
+                                 std::make_move_iterator(pieces.end()));
+}
+
+void TCPSender::_retransmit(OutstandingSegment &outstanding) {
+    // Each transmission carries the current clock, so that its echo dates this transmission.
+    auto &timestamps = outstanding.segment.header().timestamps;
+    if (timestamps.has_value())
+        timestamps.value().tsval = static_cast<uint32_t>(_now);
+    // Retransmissions are not sent ECN-capable (RFC 3168 section 6.1.5).
+    outstanding.segment.ect() = false;
+    _segments_out.push(outstanding.segment);
+    _segments_sent += outstanding.segment.wire_segment_count();
+    _retransmissions += outstanding.segment.wire_segment_count();
+    _bytes_sent += outstanding.segment.payload().size();
+    _bytes_retransmitted += outstanding.segment.payload().size();
+    outstanding.retransmitted = true;
+    outstanding.lost = false;
+    outstanding.sent_time = _now;
+    outstanding.transmissions++;
+}
+
+//! \param rtt a round-trip time measurement, in ms
+void TCPSender::_rtt_sample(const uint64_t rtt) {
+    if (!_rtt_measured) {
+        _srtt = rtt;
+        _rttvar = rtt / 2;
+        _min_rtt = rtt;
+        _rtt_measured = true;
+        return;
+    }
+    const uint64_t delta = _srtt > rtt ? _srtt - rtt : rtt - _srtt;
+    _rttvar = (3 * _rttvar + delta) / 4;
+    _srtt = (7 * _srtt + rtt) / 8;
+    _min_rtt = std::min(_min_rtt, rtt);
+}
+
+//! \param delivered a segment that was just cumulatively or selectively acknowledged
+//! \details Tracks the most recently sent delivered segment (RFC 8985 section 6.2, step 2). An ACK that
+//! arrives sooner than min_rtt after a retransmission was most likely meant for an earlier transmission.
+void TCPSender::_rack_update(const OutstandingSegment &delivered) {
+    const uint64_t rtt = _now - delivered.sent_time;
+    if (delivered.transmissions > 1 && _rtt_measured && rtt < _min_rtt)
+        return;
+
+    if (delivered.sent_time > _rack_xmit_ts ||
+        (delivered.sent_time == _rack_xmit_ts && delivered.abs_end() > _rack_end_seq)) {
+        _rack_xmit_ts = delivered.sent_time;
+        _rack_end_seq = delivered.abs_end();
+        _rack_rtt = rtt;
+    }
+}
+
+//! \returns whether any segment was newly marked lost
+//! \details A segment is lost once a segment sent after it has been delivered and more than
+//! RACK.rtt + RACK.reo_wnd has passed since it was sent (RFC 8985 section 6.2, step 5). Segments that
+//! are not lost yet but may become so arm the reordering timer.
+bool TCPSender::_rack_detect_loss() {
+    const uint64_t reo_wnd = _rtt_measured ? std::min(_min_rtt / 4, _srtt) : 0;
+    uint64_t timeout = 0;
+    bool newly_lost = false;
+
+    _rack_reorder_deadline.reset();
+    for (auto &outstanding : _segments_outstanding) {
+        if (outstanding.sacked || outstanding.lost)
+            continue;
+        const bool sent_before_delivered =
+            _rack_xmit_ts > outstanding.sent_time ||
+            (_rack_xmit_ts == outstanding.sent_time && _rack_end_seq > outstanding.abs_end());
+        if (!sent_before_delivered)
+            continue;
+
+        const uint64_t deadline = outstanding.sent_time + _rack_rtt + reo_wnd;
+        if (_now >= deadline) {
+            outstanding.lost = true;
+            outstanding.retransmitted = false;
+            newly_lost = true;
+        } else {
+            timeout = std::max(timeout, deadline - _now);
+        }
+    }
+
+    if (timeout > 0)
+        _rack_reorder_deadline = _now + timeout;
+    return newly_lost;
+}
+
+//! \details Schedules a tail loss probe (RFC 8985 section 7.2) at two smoothed RTTs, plus the peer's
+//! delayed-ACK allowance when only one segment is in flight, unless the retransmission timer would fire first.
+void TCPSender::_arm_tlp() {
+    _tlp_deadline.reset();
+    if (!_rack_tlp_enabled || _segments_outstanding.empty() || _in_recovery || _tlp_end_seq.has_value() ||
+        _state == SYN_SENT)
+        return;
+
+    uint64_t pto = TLP_INITIAL_TIMEOUT_MS;
+    if (_rtt_measured) {
+        pto = std::max(2 * _srtt, TLP_MIN_TIMEOUT_MS);
+        if (_segments_outstanding.size() == 1)
+            pto += TLP_DELAYED_ACK_MS;
+    }
+
+    const uint64_t rto_remaining =
+        _current_retransmission_timeout - std::min<uint64_t>(_timer_million_seconds, _current_retransmission_timeout);
+    if (pto < rto_remaining)
+        _tlp_deadline = _now + pto;
+}
+
+//! \details Sends new data if the window allows, and otherwise retransmits the highest outstanding segment,
+//! so that the ACK it elicits reveals a lost tail through SACK and RACK (RFC 8985 section 7.3).
+void TCPSender::_send_probe() {
+    _tlp_deadline.reset();
+    if (_segments_outstanding.empty())
+        return;
+
+    if (!stream_in().buffer_empty() && _next_seqno < _window_right) {
+        _send_segment(false, _is_fin());
+        (_segments_outstanding.back().segment.header().fin) && (_state = FIN_SENT);
+    } else {
+        // The probe is the last wire segment of a super-segment, not all of it.
+        const size_t last = _segments_outstanding.size() - 1;
+        const TCPSegment &tail = _segments_outstanding[last].segment;
+        if (tail.wire_segment_count() > 1)
+            _split_at(last, (tail.wire_segment_count() - 1) * tail.gso_size());
+        _retransmit(_repacketize(_segments_outstanding.size() - 1));
+    }
+    _tlp_end_seq = _next_seqno;
+
+    // The retransmission timer restarts from the probe.
+    _timer_million_seconds = 0;
 }
 
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
 void TCPSender::tick(const size_t ms_since_last_tick) {
+    _now += ms_since_last_tick;
+
+    // Release paced segments whose departure time has arrived.
+    if (_has_data_to_send() && pacing_rate().has_value() && _now * 1000 >= _next_departure_us)
+        _handle_transmission();
+
     if (!_is_timer_started)
         return;
 
     _timer_million_seconds += ms_since_last_tick;
 
+    // RACK's reordering window has passed for segments that were sent before a delivered one.
+    if (_rack_reorder_deadline.has_value() && _now >= _rack_reorder_deadline.value()) {
+        _rack_reorder_deadline.reset();
+        if (_rack_detect_loss())
+            _loss_recovery(false);
+    }
+
+    if (_tlp_deadline.has_value() && _now >= _tlp_deadline.value() &&
+        _timer_million_seconds < _current_retransmission_timeout) {
+        _send_probe();
+        return;
+    }
+
     if (_timer_million_seconds >= _current_retransmission_timeout) {
         _timer_million_seconds = 0;
         _retransmission_times++;
-        _segments_out.push(_segments_outstanding.front());
+        _timeouts++;
+
+        // Segments above the base MSS that keep timing out may be vanishing into a path MTU black hole: fall back
+        // to the base MSS and search upwards again (RFC 4821 section 7.7).
+        if (_plpmtud_enabled && _retransmission_times >= PLPMTUD_BLACK_HOLE_RTOS && _mss > PLPMTUD_BASE_MSS &&
+            _segments_outstanding.front().segment.payload().size() > PLPMTUD_BASE_MSS) {
+            _mtu_search_high = _mss;
+            _mss = _mtu_search_low = PLPMTUD_BASE_MSS;
+            _mtu_probe_seqno.reset();
+        }
+        _retransmit(_repacketize(0));
+
+        // A timeout ends SACK recovery (RFC 6675 section 5.1) and any probe episode; the scoreboard's SACK
+        // marks are kept so that SACKed data is not sent again.
+        _in_recovery = false;
+        _dup_acks = 0;
+        _tlp_end_seq.reset();
+        _tlp_deadline.reset();
         if (_retransmission_times <= TCPConfig::MAX_RETX_ATTEMPTS && !_is_probing())
             _current_retransmission_timeout *= 2;
     }
 }
 
+void TCPSender::flush() {
+    _push_point = stream_in().bytes_written() + 1;
+    fill_window();
+}
+
+//! \param[in] cork whether to accumulate data into full segments
+void TCPSender::set_cork(const bool cork) {
+    _corked = cork;
+    if (!cork)
+        flush();
+}
+
 unsigned int TCPSender::consecutive_retransmissions() const { return _retransmission_times; }
 
+//! \param[out] info the snapshot; the receiver's fields are left alone
+void TCPSender::fill_info(TCPInfo &info) const {
+    info.bytes_sent = _bytes_sent;
+    // The SYN and FIN are not payload: ackno 1 acknowledges the SYN alone, and the FIN follows every byte read.
+    info.bytes_acked = std::min(_bytes_acked - std::min<uint64_t>(_bytes_acked, 1), _stream.bytes_read());
+    info.bytes_retransmitted = _bytes_retransmitted;
+    info.bytes_in_flight = bytes_in_flight();
+    info.segments_out = _segments_sent;
+    info.retransmissions = _retransmissions;
+    info.timeouts = _timeouts;
+    info.consecutive_timeouts = _retransmission_times;
+    info.rto_ms = _current_retransmission_timeout;
+    info.srtt_ms = _srtt;
+    info.rttvar_ms = _rttvar;
+    info.rtt_valid = _rtt_measured;
+    info.snd_wnd = _window_right - std::min(_window_right, _bytes_acked);
+    info.mss = _mss;
+    info.snd_capacity = _stream.capacity();
+}
+
 void TCPSender::send_empty_segment() {}
\ No newline at end of file
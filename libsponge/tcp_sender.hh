@@ -3,14 +3,31 @@
 
 #include "byte_stream.hh"
 #include "tcp_config.hh"
+#include "tcp_info.hh"
+#include "tcp_memory.hh"
 #include "tcp_segment.hh"
 #include "wrapping_integers.hh"
 
 #include <functional>
+#include <optional>
 #include <queue>
 
 enum SenderState { CLOSED, SYN_SENT, SYN_ACKED, FIN_SENT, FIN_ACKED, SERROR};
 
+//! \brief A segment that has been sent but not yet cumulatively acknowledged
+struct OutstandingSegment {
+    TCPSegment segment;             //!< the segment as it was first sent
+    uint64_t abs_seqno;             //!< absolute sequence number of the segment's first byte
+    uint64_t sent_time;             //!< sender clock (ms) at the segment's most recent transmission
+    unsigned int transmissions{1};  //!< how many times the segment has been sent
+    bool sacked{false};             //!< the peer has selectively acknowledged the segment
+    bool retransmitted{false};      //!< the segment was retransmitted during the current loss recovery
+    bool lost{false};               //!< RACK deemed this transmission of the segment lost
+
+    //! absolute sequence number immediately following the segment
+    uint64_t abs_end() const { return abs_seqno + segment.length_in_sequence_space(); }
+};
+
 //! \brief The "sender" part of a TCP implementation.
 
 //! Accepts a ByteStream, divides it up into segments and sends the
@@ -25,7 +42,13 @@ class TCPSender {
     //! outbound queue of segments that the TCPSender wants sent
     std::queue<TCPSegment> _segments_out{};
 
-    std::vector<TCPSegment> _segments_outstanding{};
+    //! segments sent but not yet cumulatively acknowledged, in sequence order (the SACK scoreboard)
+    std::vector<OutstandingSegment> _segments_outstanding{};
+
+    //! Reused by _loss_recovery(): for each outstanding segment, whether the SACKs above it show it lost (RFC 6675
+    //! IsLost, leaving out RACK's marks), and its share of the pipe
+    std::vector<bool> _sack_lost{};
+    std::vector<uint64_t> _pipe_shares{};
 
     //! retransmission timer for the connection
     unsigned int _initial_retransmission_timeout;
@@ -54,12 +77,290 @@ class TCPSender {
 
     bool _is_zero_window{false};
 
+    //! \name SACK-based loss recovery ([RFC 6675](https://tools.ietf.org/html/rfc6675))
+    //!@{
+
+    //! number of SACKed segments above a hole before the hole is deemed lost
+    static constexpr unsigned DUP_THRESH = 3;
+
+    //! offer SACK-permitted on our SYN
+    bool _sack_offered{false};
+
+    //! the peer's SYN carried SACK-permitted
+    bool _peer_sack_permitted{false};
+
+    //! consecutive duplicate ACKs that newly SACKed data
+    unsigned int _dup_acks{0};
+
+    bool _in_recovery{false};
+
+    //! HighData when loss recovery began; recovery ends once this is cumulatively acknowledged
+    uint64_t _recovery_point{0};
+
+    //! congestion window in effect during loss recovery (outside recovery only the peer's window applies)
+    uint64_t _cwnd{0};
+    //!@}
+
+    //! \name Window scaling ([RFC 7323](\ref rfc::rfc7323))
+    //!@{
+
+    //! put the window scale option on our SYN
+    bool _window_scale_offered{false};
+
+    //! the shift our SYN offers, describing our receive window
+    uint8_t _rcv_window_shift{0};
+
+    //! the shift applied to the peer's window advertisements, once both SYNs carried the option
+    uint8_t _snd_window_shift{0};
+
+    //! the peer's SYN has been seen, so our SYN may only include the option if the peer's did
+    bool _peer_syn_seen{false};
+
+    //! the shift offered on the peer's SYN
+    std::optional<uint8_t> _peer_window_shift{};
+    //!@}
+
+    //! \name Timestamps ([RFC 7323](\ref rfc::rfc7323))
+    //!@{
+
+    //! put the timestamps option on our SYN
+    bool _timestamps_offered{false};
+
+    //! the peer's SYN carried timestamps too, so every segment carries them
+    bool _peer_timestamps{false};
+    //!@}
+
+    //! \name Maximum segment size and path MTU discovery ([RFC 4821](https://tools.ietf.org/html/rfc4821))
+    //!@{
+
+    //! MSS that black hole detection falls back to (the default MSS of RFC 9293)
+    static constexpr size_t PLPMTUD_BASE_MSS = 536;
+
+    //! the search ends once the largest working and smallest failing sizes are this close
+    static constexpr size_t PLPMTUD_SEARCH_DONE = 32;
+
+    //! consecutive timeouts of a segment above the base MSS before the path is deemed a black hole
+    static constexpr unsigned PLPMTUD_BLACK_HOLE_RTOS = 2;
+
+    //! payload size of the segments being sent
+    size_t _mss{TCPConfig::MAX_PAYLOAD_SIZE};
+
+    //! the MSS offered on our SYN
+    uint16_t _mss_offered{TCPConfig::MAX_PAYLOAD_SIZE};
+
+    bool _plpmtud_enabled{false};
+
+    //! largest payload known to get through, and smallest known not to (or one past the largest allowed)
+    size_t _mtu_search_low{TCPConfig::MAX_PAYLOAD_SIZE};
+    size_t _mtu_search_high{TCPConfig::MAX_PAYLOAD_SIZE + 1};
+
+    //! absolute seqno of the probe in flight, if any, and its payload size
+    std::optional<uint64_t> _mtu_probe_seqno{};
+    size_t _mtu_probe_size{0};
+    //!@}
+
+    //! \name TCP Fast Open ([RFC 7413](https://tools.ietf.org/html/rfc7413))
+    //!@{
+
+    //! the cookie our SYN presents (empty requests one), if Fast Open is in use
+    std::optional<std::string> _fastopen_cookie{};
+
+    //! the cookie the peer's SYN-ACK issued
+    std::optional<std::string> _peer_fastopen_cookie{};
+    //!@}
+
+    //! \name ECN ([RFC 3168](https://tools.ietf.org/html/rfc3168)) and DCTCP
+    //!@{
+
+    //! initial congestion window, in segments ([RFC 6928](https://tools.ietf.org/html/rfc6928))
+    static constexpr uint64_t INITIAL_WINDOW_SEGMENTS = 10;
+
+    //! DCTCP's gain is 1 / 2^DCTCP_G_SHIFT ([RFC 8257](https://tools.ietf.org/html/rfc8257) section 4.2)
+    static constexpr unsigned DCTCP_G_SHIFT = 4;
+
+    //! fixed-point scale of DCTCP's alpha
+    static constexpr uint64_t DCTCP_ALPHA_ONE = 1024;
+
+    //! offer ECN on our SYN
+    bool _ecn_offered{false};
+
+    //! the peer's SYN agreed to ECN
+    bool _peer_ecn{false};
+
+    bool _dctcp{false};
+
+    //! congestion window and slow start threshold, which apply once ECN is negotiated: marks are a congestion
+    //! signal that arrives without loss, so there must be a window for them to shrink
+    uint64_t _ecn_cwnd{0};
+    uint64_t _ssthresh{UINT64_MAX};
+
+    //! HighData at the last reduction; marks on data sent before it do not reduce the window again
+    uint64_t _ecn_recover{0};
+
+    //! the next new data segment carries CWR
+    bool _send_cwr{false};
+
+    //! DCTCP's estimate of the fraction of bytes marked, scaled by DCTCP_ALPHA_ONE
+    uint64_t _dctcp_alpha{DCTCP_ALPHA_ONE};
+
+    //! bytes acknowledged, and acknowledged with ECE, in the observation window that ends at _dctcp_window_end
+    uint64_t _dctcp_bytes_acked{0};
+    uint64_t _dctcp_bytes_marked{0};
+    uint64_t _dctcp_window_end{0};
+    //!@}
+
+    //! \name RACK-TLP loss detection ([RFC 8985](https://tools.ietf.org/html/rfc8985))
+    //!@{
+
+    //! extra probe delay when a single segment is in flight, to cover the peer's delayed ACK
+    static constexpr uint64_t TLP_DELAYED_ACK_MS = 200;
+
+    //! smallest probe timeout
+    static constexpr uint64_t TLP_MIN_TIMEOUT_MS = 10;
+
+    //! probe timeout used before any RTT has been measured
+    static constexpr uint64_t TLP_INITIAL_TIMEOUT_MS = 1000;
+
+    bool _rack_tlp_enabled{false};
+
+    //! the sender's clock: milliseconds passed to tick() so far
+    uint64_t _now{0};
+
+    //! smoothed RTT and RTT variation ([RFC 6298](\ref rfc::rfc6298)), in ms; valid once `_rtt_measured`
+    uint64_t _srtt{0};
+    uint64_t _rttvar{0};
+    uint64_t _min_rtt{0};
+    bool _rtt_measured{false};
+
+    //! transmit time, end and RTT of the most recently sent segment known to be delivered
+    uint64_t _rack_xmit_ts{0};
+    uint64_t _rack_end_seq{0};
+    uint64_t _rack_rtt{0};
+
+    //! when segments that are not yet deemed lost should be checked again
+    std::optional<uint64_t> _rack_reorder_deadline{};
+
+    //! when the tail loss probe fires
+    std::optional<uint64_t> _tlp_deadline{};
+
+    //! end of the probe's sequence range while a probe is unacknowledged
+    std::optional<uint64_t> _tlp_end_seq{};
+    //!@}
+
+    //! \name Pacing
+    //!@{
+
+    //! pacing rate as a percentage of the window per smoothed RTT, leaving headroom over the ACK clock
+    static constexpr uint64_t PACING_GAIN_PERCENT = 120;
+
+    bool _pacing_enabled{false};
+
+    //! configured ceiling on the pacing rate, in bytes per second (0 means none)
+    uint64_t _pacing_rate_cap{0};
+
+    //! earliest time the next new segment may leave, in microseconds on the sender clock
+    uint64_t _next_departure_us{0};
+    //!@}
+
+    //! \name Send coalescing
+    //!@{
+
+    bool _nagle{false};
+
+    bool _corked{false};
+
+    //! build GSO super-segments of up to TCPConfig::MAX_GSO_PAYLOAD_SIZE
+    bool _gso_enabled{false};
+
+    //! merge small outstanding segments on retransmission
+    bool _repacketize_enabled{false};
+
+    //! absolute seqno just past the last byte that was written before the most recent flush
+    uint64_t _push_point{0};
+    //!@}
+
+    //! \name Send buffer autotuning
+    //!@{
+    bool _autotune{false};
+
+    //! the configured capacity, and the largest the outbound stream may grow to
+    size_t _base_capacity;
+    size_t _max_capacity;
+
+    //! growth beyond the configured capacity, held as a share of the memory budget
+    TCPMemoryShare _memory{};
+    //!@}
+
+    //! \name Statistics reported by fill_info()
+    //!@{
+    uint64_t _bytes_sent{0};
+    uint64_t _bytes_retransmitted{0};
+    uint64_t _segments_sent{0};
+    uint64_t _retransmissions{0};
+    uint64_t _timeouts{0};
+    //!@}
+
+    void _ack_received(const WrappingInt32 ackno,
+                       const uint64_t window_size,
+                       const TCPHeader::SACKBlocks &sack_blocks,
+                       const std::optional<uint32_t> tsecr,
+                       const bool ece);
+
+    void _ecn_ack(const uint64_t acked, const bool ece);
+
+    void _autotune_capacity();
+
+    bool _update_scoreboard(const TCPHeader::SACKBlocks &sack_blocks);
+
+    bool _is_lost(const size_t index) const;
+
+    uint64_t _pipe() const;
+
+    uint64_t _scan_scoreboard();
+
+    uint64_t _pipe_share(const size_t index) const;
+
+    void _recovery_retransmit(const size_t index, uint64_t &pipe);
+
+    void _loss_recovery(const bool dup_ack);
+
+    OutstandingSegment &_repacketize(const size_t index);
+
+    void _split(const size_t index);
+
+    void _split(const size_t index, const size_t piece_size);
+
+    void _split_at(const size_t index, const size_t offset);
+
+    void _retransmit(OutstandingSegment &outstanding);
+
+    void _rtt_sample(const uint64_t rtt);
+
+    void _rack_update(const OutstandingSegment &delivered);
+
+    bool _rack_detect_loss();
+
+    void _arm_tlp();
+
+    void _send_probe();
+
+    bool _has_data_to_send() const;
+
+    bool _should_hold() const;
+
+    size_t _max_payload_size() const;
+
+    size_t _next_mtu_probe_size() const;
+
   public:
     //! Initialize a TCPSender
     TCPSender(const size_t capacity = TCPConfig::DEFAULT_CAPACITY,
               const uint16_t retx_timeout = TCPConfig::TIMEOUT_DFLT,
               const std::optional<WrappingInt32> fixed_isn = {});
 
+    //! Initialize a TCPSender from a connection's configuration
+    explicit TCPSender(const TCPConfig &config);
+
     //! \name "Input" interface for the writer
     //!@{
     ByteStream &stream_in() { return _stream; }
@@ -72,6 +373,10 @@ class TCPSender {
     //! \brief A new acknowledgment was received
     void ack_received(const WrappingInt32 ackno, const uint16_t window_size);
 
+    //! \brief A segment was received from the peer; its ackno, window and SACK options are used
+    //! \note The peer's SYN must be passed here for SACK and window scaling to be negotiated
+    void ack_received(const TCPHeader &header);
+
     //! \brief Generate an empty-payload segment (useful for creating empty ACK segments)
     void send_empty_segment();
 
@@ -81,6 +386,13 @@ class TCPSender {
     //! \brief Notifies the TCPSender of the passage of time
     void tick(const size_t ms_since_last_tick);
 
+    //! \brief Send everything written so far without waiting to fill a segment, marking its end with PSH
+    void flush();
+
+    //! \brief Cork or uncork the sender; while corked only full segments are sent
+    //! \note Uncorking flushes.
+    void set_cork(const bool cork);
+
     void _send_segment(bool syn, bool fin);
 
     void _handle_closed();
@@ -105,10 +417,66 @@ class TCPSender {
     //! \brief Number of consecutive retransmissions that have occurred in a row
     unsigned int consecutive_retransmissions() const;
 
+    //! \brief Whether both sides agreed to use SACK
+    bool sack_enabled() const { return _sack_offered && _peer_sack_permitted; }
+
+    //! \brief The shift applied to the peer's window advertisements (0 unless window scaling was negotiated)
+    uint8_t window_shift() const { return _snd_window_shift; }
+
+    //! \brief Whether both sides agreed to use timestamps
+    bool timestamps_enabled() const { return _timestamps_offered && _peer_timestamps; }
+
+    //! \brief Payload size of the segments being sent (the smaller of ours and the peer's MSS, less any that
+    //! path MTU discovery has not yet shown to get through)
+    size_t mss() const { return _mss; }
+
+    //! \brief Payload size of the path MTU probe in flight, if any
+    std::optional<size_t> mtu_probe_size() const {
+        return _mtu_probe_seqno.has_value() ? std::optional<size_t>{_mtu_probe_size} : std::nullopt;
+    }
+
+    //! \brief Whether both sides agreed to use ECN
+    bool ecn_enabled() const { return _ecn_offered && _peer_ecn; }
+
+    //! \brief The congestion window, in bytes, once ECN is negotiated
+    std::optional<uint64_t> congestion_window() const {
+        return ecn_enabled() ? std::optional<uint64_t>{_ecn_cwnd} : std::nullopt;
+    }
+
+    //! \brief DCTCP's estimate of the fraction of bytes marked, in 1/1024ths
+    uint64_t dctcp_alpha() const { return _dctcp_alpha; }
+
+    //! \brief The TCP Fast Open cookie issued on the peer's SYN-ACK, to be kept in a TCPFastOpenCache
+    std::optional<std::string> fastopen_cookie() const { return _peer_fastopen_cookie; }
+
+    //! \brief Whether the sender is repairing losses reported by SACK
+    bool in_recovery() const { return _in_recovery; }
+
+    //! \brief Smoothed round-trip time in milliseconds, once one has been measured
+    std::optional<uint64_t> srtt() const { return _rtt_measured ? std::optional<uint64_t>{_srtt} : std::nullopt; }
+
+    //! \brief Whether the sender is corked
+    bool corked() const { return _corked; }
+
+    //! \brief Fill in the sender's half of `info` (see TCPInfo)
+    void fill_info(TCPInfo &info) const;
+
+    //! \brief When the next tail loss probe is due, on the clock advanced by tick(), if one is armed
+    std::optional<uint64_t> tlp_deadline() const { return _tlp_deadline; }
+
+    //! \brief The rate at which new segments are released, in bytes per second
+    //! \returns empty if pacing is off, or if there is neither a measured RTT nor a configured cap
+    std::optional<uint64_t> pacing_rate() const;
+
+    //! \brief When the next paced segment may be sent, in ms on the clock advanced by tick()
+    //! \returns empty unless pacing is holding back data that the window would otherwise allow
+    //! \note An event loop should call tick() no later than this time.
+    std::optional<uint64_t> next_departure() const;
+
     //! \brief TCPSegments that the TCPSender has enqueued for transmission.
     //! \note These must be dequeued and sent by the TCPConnection,
     //! which will need to fill in the fields that are set by the TCPReceiver
-    //! (ackno and window size) before sending.
+    //! (ackno, window size, ECE, and the TSecr of any timestamps option) before sending.
     std::queue<TCPSegment> &segments_out() { return _segments_out; }
     //!@}
 
@@ -1,17 +1,94 @@
 #include "buffer.hh"
 
+#include "util.hh"
+
 using namespace std;
 
+namespace {
+
+//! The partial checksum of `bytes`, summed from the first
+uint16_t sum_of(const string_view bytes) {
+    InternetChecksum check;
+    check.add(bytes);
+    return check.partial();
+}
+
+//! The ones-complement difference `a - b` of two partial checksums
+uint16_t difference(const uint16_t a, const uint16_t b) {
+    InternetChecksum check(a);
+    check.add_partial(static_cast<uint16_t>(~b), 0);
+    return check.partial();
+}
+
+uint16_t swap_bytes(const uint16_t value) { return static_cast<uint16_t>((value >> 8) | (value << 8)); }
+
+}  // namespace
+
+uint16_t Buffer::partial_sum() const {
+    if (not _partial_sum_valid) {
+        _partial_sum = sum_of(str());
+        _partial_sum_valid = true;
+    }
+    return _partial_sum;
+}
+
+//! \details The sum of the whole string is the sum of the first `n` bytes plus that of the rest, whose bytes
+//! swap halves of their words if `n` is odd ([RFC 1071](https://tools.ietf.org/html/rfc1071) section 2(B)).
 void Buffer::remove_prefix(const size_t n) {
     if (n > str().size()) {
         throw out_of_range("Buffer::remove_prefix");
     }
+    if (n == 0) {
+        return;
+    }
+    if (_partial_sum_valid and n < _size - n) {
+        const uint16_t rest = difference(_partial_sum, sum_of(str().substr(0, n)));
+        _partial_sum = n % 2 == 1 ? swap_bytes(rest) : rest;
+    } else {
+        _partial_sum_valid = false;
+    }
     _starting_offset += n;
-    if (_storage and _starting_offset == _storage->size()) {
+    _size -= n;
+    if (_storage and _size == 0) {
         _storage.reset();
     }
 }
 
+void Buffer::remove_suffix(const size_t n) {
+    if (n > str().size()) {
+        throw out_of_range("Buffer::remove_suffix");
+    }
+    if (n == 0) {
+        return;
+    }
+    if (_partial_sum_valid and n < _size - n) {
+        const uint16_t suffix = sum_of(str().substr(_size - n));
+        _partial_sum = difference(_partial_sum, (_size - n) % 2 == 1 ? swap_bytes(suffix) : suffix);
+    } else {
+        _partial_sum_valid = false;
+    }
+    _size -= n;
+    if (_storage and _size == 0) {
+        _storage.reset();
+    }
+}
+
+bool Buffer::try_append(const string_view data) {
+    if (not _storage or _storage.use_count() != 1 or _starting_offset + _size != _storage->size() or
+        _starting_offset > _size) {
+        return false;
+    }
+    if (_partial_sum_valid) {
+        InternetChecksum check;
+        check.add_partial(_partial_sum, _size);
+        check.add(data);
+        _partial_sum = check.partial();
+    }
+    _storage->append(data);
+    _size += data.size();
+    return true;
+}
+
 void BufferList::append(const BufferList &other) {
     for (const auto &buf : other._buffers) {
         _buffers.push_back(buf);
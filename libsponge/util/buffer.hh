@@ -2,6 +2,7 @@
 #define SPONGE_LIBSPONGE_BUFFER_HH
 
 #include <algorithm>
+#include <cstdint>
 #include <deque>
 #include <memory>
 #include <numeric>
@@ -11,17 +12,32 @@
 #include <sys/uio.h>
 #include <vector>
 
-//! \brief A reference-counted read-only string that can discard bytes from the front
+//! \brief A reference-counted read-only string that can discard bytes from either end
+//! \note Copies share the underlying storage, so a copy trimmed with remove_prefix() and remove_suffix() is a
+//! zero-copy slice of the original.
 class Buffer {
   private:
     std::shared_ptr<std::string> _storage{};
     size_t _starting_offset{};
+    size_t _size{};
+
+    //! partial_sum(), once it has been computed
+    mutable uint16_t _partial_sum{0};
+    mutable bool _partial_sum_valid{false};
 
   public:
     Buffer() = default;
 
     //! \brief Construct by taking ownership of a string
-    Buffer(std::string &&str) noexcept : _storage(std::make_shared<std::string>(std::move(str))) {}
+    Buffer(std::string &&str) noexcept
+        : _storage(std::make_shared<std::string>(std::move(str))), _size(_storage->size()) {}
+
+    //! \brief Construct by taking ownership of a string whose partial checksum is already known (e.g. because it
+    //! was computed while the string was copied together)
+    Buffer(std::string &&str, const uint16_t partial_sum) noexcept : Buffer(std::move(str)) {
+        _partial_sum = partial_sum;
+        _partial_sum_valid = true;
+    }
 
     //! \name Expose contents as a std::string_view
     //!@{
@@ -29,7 +45,7 @@ class Buffer {
         if (not _storage) {
             return {};
         }
-        return {_storage->data() + _starting_offset, _storage->size() - _starting_offset};
+        return {_storage->data() + _starting_offset, _size};
     }
 
     operator std::string_view() const { return str(); }
@@ -44,9 +60,31 @@ class Buffer {
     //! \brief Make a copy to a new std::string
     std::string copy() const { return std::string(str()); }
 
+    //! \brief Bytes of storage this Buffer keeps allocated, which its copies and slices share
+    size_t storage_capacity() const { return _storage ? _storage->capacity() : 0; }
+
+    //! \brief The partial checksum of the string (see InternetChecksum::partial()), summed from its first byte
+    //! \note Computed the first time it is asked for, and kept: copies made afterwards, e.g. of a payload that is
+    //! retransmitted or forwarded, have it without reading the bytes again.
+    uint16_t partial_sum() const;
+
     //! \brief Discard the first `n` bytes of the string (does not require a copy or move)
     //! \note Doesn't free any memory until the whole string has been discarded in all copies of the Buffer.
+    //! A partial_sum() already computed is adjusted by the sum of the bytes discarded, if there are fewer of
+    //! them than remain, and otherwise forgotten.
     void remove_prefix(const size_t n);
+
+    //! \brief Discard the last `n` bytes of the string (does not require a copy or move)
+    //! \note Doesn't free any memory until the whole string has been discarded in all copies of the Buffer.
+    //! A partial_sum() already computed is kept as remove_prefix() keeps it.
+    void remove_suffix(const size_t n);
+
+    //! \brief Append `data` to the string in place, if no other Buffer shares its storage, the string ends where
+    //! the storage does, and no more has been discarded from its front than remains (so that storage kept alive by
+    //! appends stays within twice what is in use)
+    //! \returns whether the bytes were appended (otherwise the Buffer is unchanged)
+    //! \note A partial_sum() already computed is extended by the sum of the bytes appended.
+    bool try_append(const std::string_view data);
 };
 
 //! \brief A reference-counted discontiguous string that can discard bytes from the front
@@ -3,6 +3,7 @@
 #include <array>
 #include <cctype>
 #include <chrono>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
@@ -69,6 +70,170 @@ mt19937 get_random_generator() {
     return mt19937(seed);
 }
 
+#if defined(__x86_64__) && defined(__GNUC__)
+#define SPONGE_CHECKSUM_AVX2
+#include <immintrin.h>
+#endif
+
+namespace {
+
+//! Ones' complement addition of 64-bit words: the carry out of the top wraps around to the bottom
+uint64_t add_with_carry(const uint64_t a, const uint64_t b) {
+    const uint64_t sum = a + b;
+    return sum + (sum < b);
+}
+
+//! Fold a ones' complement sum of any width down to 16 bits
+uint16_t fold(uint64_t sum) {
+    while (sum > 0xffff) {
+        sum = (sum >> 16) + (sum & 0xffff);
+    }
+    return sum;
+}
+
+uint16_t swap_bytes(const uint16_t value) { return (value >> 8) | (value << 8); }
+
+//! Convert a sum of 16-bit words in host byte order to the sum of the same words in network byte order
+uint16_t to_network_order(const uint16_t sum) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    return swap_bytes(sum);
+#else
+    return sum;
+#endif
+}
+
+//! \brief Ones' complement sum of `len` bytes, read as 16-bit words in host byte order
+//! \details An odd final byte is padded with zero, as if it began a word. The sum of words in host byte order is
+//! the byte-swapped sum of the same words in network byte order ([RFC 1071](https://tools.ietf.org/html/rfc1071)
+//! section 2(B)), so the words can be loaded eight bytes at a time without swapping each one.
+uint64_t sum_words_scalar(const uint8_t *data, size_t len) {
+    uint64_t sum = 0;
+    uint64_t words[4];
+    for (; len >= sizeof(words); data += sizeof(words), len -= sizeof(words)) {
+        memcpy(words, data, sizeof(words));
+        sum = add_with_carry(sum, words[0]);
+        sum = add_with_carry(sum, words[1]);
+        sum = add_with_carry(sum, words[2]);
+        sum = add_with_carry(sum, words[3]);
+    }
+    for (; len >= sizeof(uint64_t); data += sizeof(uint64_t), len -= sizeof(uint64_t)) {
+        memcpy(words, data, sizeof(uint64_t));
+        sum = add_with_carry(sum, words[0]);
+    }
+    words[0] = 0;
+    memcpy(words, data, len);
+    return add_with_carry(sum, words[0]);
+}
+
+#ifdef SPONGE_CHECKSUM_AVX2
+//! \brief sum_words_scalar() with AVX2, 32 bytes at a time
+//! \details Each 32-bit lane adds up the two 16-bit words it is loaded with. A lane gains less than 2^17 per
+//! load, so it is emptied into the 64-bit sum before 2^14 loads can overflow it.
+__attribute__((target("avx2"))) uint64_t sum_words_avx2(const uint8_t *data, size_t len) {
+    static constexpr size_t BLOCK_LOADS = 1 << 14;
+    const __m256i low_words = _mm256_set1_epi32(0xffff);
+    uint64_t sum = 0;
+    while (len >= sizeof(__m256i)) {
+        const size_t loads = min(len / sizeof(__m256i), BLOCK_LOADS);
+        __m256i lanes = _mm256_setzero_si256();
+        for (size_t i = 0; i < loads; i++, data += sizeof(__m256i)) {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data));
+            lanes = _mm256_add_epi32(lanes, _mm256_and_si256(v, low_words));
+            lanes = _mm256_add_epi32(lanes, _mm256_srli_epi32(v, 16));
+        }
+        len -= loads * sizeof(__m256i);
+
+        alignas(sizeof(__m256i)) uint32_t lane_sums[8];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(lane_sums), lanes);
+        for (const uint32_t lane_sum : lane_sums) {
+            sum += lane_sum;
+        }
+    }
+    return add_with_carry(sum, sum_words_scalar(data, len));
+}
+#endif  // SPONGE_CHECKSUM_AVX2
+
+//! \brief sum_words_scalar() that also copies the bytes to `dst`, in the same pass
+uint64_t copy_and_sum_words_scalar(uint8_t *dst, const uint8_t *src, size_t len) {
+    uint64_t sum = 0;
+    uint64_t words[4];
+    for (; len >= sizeof(words); src += sizeof(words), dst += sizeof(words), len -= sizeof(words)) {
+        memcpy(words, src, sizeof(words));
+        memcpy(dst, words, sizeof(words));
+        sum = add_with_carry(sum, words[0]);
+        sum = add_with_carry(sum, words[1]);
+        sum = add_with_carry(sum, words[2]);
+        sum = add_with_carry(sum, words[3]);
+    }
+    for (; len >= sizeof(uint64_t); src += sizeof(uint64_t), dst += sizeof(uint64_t), len -= sizeof(uint64_t)) {
+        memcpy(words, src, sizeof(uint64_t));
+        memcpy(dst, words, sizeof(uint64_t));
+        sum = add_with_carry(sum, words[0]);
+    }
+    words[0] = 0;
+    memcpy(words, src, len);
+    memcpy(dst, words, len);
+    return add_with_carry(sum, words[0]);
+}
+
+#ifdef SPONGE_CHECKSUM_AVX2
+//! \brief copy_and_sum_words_scalar() with AVX2, as in sum_words_avx2()
+__attribute__((target("avx2"))) uint64_t copy_and_sum_words_avx2(uint8_t *dst, const uint8_t *src, size_t len) {
+    static constexpr size_t BLOCK_LOADS = 1 << 14;
+    const __m256i low_words = _mm256_set1_epi32(0xffff);
+    uint64_t sum = 0;
+    while (len >= sizeof(__m256i)) {
+        const size_t loads = min(len / sizeof(__m256i), BLOCK_LOADS);
+        __m256i lanes = _mm256_setzero_si256();
+        for (size_t i = 0; i < loads; i++, src += sizeof(__m256i), dst += sizeof(__m256i)) {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), v);
+            lanes = _mm256_add_epi32(lanes, _mm256_and_si256(v, low_words));
+            lanes = _mm256_add_epi32(lanes, _mm256_srli_epi32(v, 16));
+        }
+        len -= loads * sizeof(__m256i);
+
+        alignas(sizeof(__m256i)) uint32_t lane_sums[8];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(lane_sums), lanes);
+        for (const uint32_t lane_sum : lane_sums) {
+            sum += lane_sum;
+        }
+    }
+    return add_with_carry(sum, copy_and_sum_words_scalar(dst, src, len));
+}
+#endif  // SPONGE_CHECKSUM_AVX2
+
+bool have_avx2() {
+#ifdef SPONGE_CHECKSUM_AVX2
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+#else
+    return false;
+#endif
+}
+
+//! sum_words_scalar(), or a faster equivalent if the CPU has one
+uint64_t sum_words(const uint8_t *data, const size_t len) {
+#ifdef SPONGE_CHECKSUM_AVX2
+    if (have_avx2()) {
+        return sum_words_avx2(data, len);
+    }
+#endif
+    return sum_words_scalar(data, len);
+}
+
+//! copy_and_sum_words_scalar(), or a faster equivalent if the CPU has one
+uint64_t copy_and_sum_words(uint8_t *dst, const uint8_t *src, const size_t len) {
+#ifdef SPONGE_CHECKSUM_AVX2
+    if (have_avx2()) {
+        return copy_and_sum_words_avx2(dst, src, len);
+    }
+#endif
+    return copy_and_sum_words_scalar(dst, src, len);
+}
+
+}  // namespace
+
 //! \note This class returns the checksum in host byte order.
 //!       See https://commandcenter.blogspot.com/2012/04/byte-order-fallacy.html for rationale
 //! \details This class can be used to either check or compute an Internet checksum
@@ -86,25 +251,74 @@ mt19937 get_random_generator() {
 //! on the Internet checksum, and consult the [IP](\ref rfc::rfc791) and [TCP](\ref rfc::rfc793) RFCs.
 InternetChecksum::InternetChecksum(const uint32_t initial_sum) : _sum(initial_sum) {}
 
+//! \details The bytes continue those of earlier calls: after an odd number of bytes, the first byte here
+//! completes the word that the last one began.
 void InternetChecksum::add(std::string_view data) {
-    for (size_t i = 0; i < data.size(); i++) {
-        uint16_t val = uint8_t(data[i]);
-        if (not _parity) {
-            val <<= 8;
-        }
-        _sum += val;
-        _parity = !_parity;
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data.data());
+    size_t len = data.size();
+    if (_parity and len > 0) {
+        _sum += bytes[0];
+        bytes++;
+        len--;
+        _parity = false;
     }
+    if (len == 0) {
+        return;
+    }
+
+    add_partial(to_network_order(fold(sum_words(bytes, len))), len);
 }
 
-uint16_t InternetChecksum::value() const {
-    uint32_t ret = _sum;
+//! \param[out] dst where to copy the bytes; must have room for all of them, and not overlap them
+//! \param[in] data the bytes to copy and add
+//! \details The same as `memcpy(dst, data.data(), data.size())` followed by `add(data)`, but the bytes are loaded
+//! once, and summed from the registers they are copied through.
+void InternetChecksum::copy_and_add(char *dst, std::string_view data) {
+    uint8_t *out = reinterpret_cast<uint8_t *>(dst);
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data.data());
+    size_t len = data.size();
+    if (_parity and len > 0) {
+        *out++ = bytes[0];
+        _sum += bytes[0];
+        bytes++;
+        len--;
+        _parity = false;
+    }
+    if (len == 0) {
+        return;
+    }
 
-    while (ret > 0xffff) {
-        ret = (ret >> 16) + (ret & 0xffff);
+    add_partial(to_network_order(fold(copy_and_sum_words(out, bytes, len))), len);
+}
+
+//! \param[in] partial_sum the partial() of the bytes, summed from an even offset
+//! \param[in] len the number of bytes
+//! \details After an odd number of bytes, each of these bytes lands in the other half of its word, which swaps
+//! the bytes of their sum ([RFC 1071](https://tools.ietf.org/html/rfc1071) section 2(B)).
+void InternetChecksum::add_partial(const uint16_t partial_sum, const size_t len) {
+    _sum += _parity ? swap_bytes(partial_sum) : partial_sum;
+    _parity ^= len % 2 == 1;
+}
+
+void InternetChecksum::add_buffers(const BufferList &buffers) {
+    for (const auto &buffer : buffers.buffers()) {
+        add_buffer(buffer);
     }
+}
+
+uint16_t InternetChecksum::value() const { return ~fold(_sum); }
+
+uint16_t InternetChecksum::partial() const { return fold(_sum); }
+
+//! \details Following RFC 1624 equation 3, HC' = ~(~HC + ~m + m'), which unlike equation 2 cannot produce a
+//! checksum of 0xffff where a full recomputation gives 0x0000.
+uint16_t InternetChecksum::update_u16(const uint16_t checksum, const uint16_t old_value, const uint16_t new_value) {
+    return ~fold(uint64_t{static_cast<uint16_t>(~checksum)} + static_cast<uint16_t>(~old_value) + new_value);
+}
 
-    return ~ret;
+uint16_t InternetChecksum::update_u32(const uint16_t checksum, const uint32_t old_value, const uint32_t new_value) {
+    const uint16_t high = update_u16(checksum, old_value >> 16, new_value >> 16);
+    return update_u16(high, old_value & 0xffff, new_value & 0xffff);
 }
 
 //! \param[in] data is a pointer to the bytes to show
@@ -1,6 +1,8 @@
 #ifndef SPONGE_LIBSPONGE_UTIL_HH
 #define SPONGE_LIBSPONGE_UTIL_HH
 
+#include "buffer.hh"
+
 #include <algorithm>
 #include <cerrno>
 #include <cstddef>
@@ -52,15 +54,42 @@ std::mt19937 get_random_generator();
 uint64_t timestamp_ms();
 
 //! The internet checksum algorithm
+//! \details add() sums 32 bytes at a time with AVX2 where the CPU supports it, and 8 bytes at a time otherwise.
 class InternetChecksum {
   private:
-    uint32_t _sum;
+    uint64_t _sum;
     bool _parity{};
 
   public:
     InternetChecksum(const uint32_t initial_sum = 0);
     void add(std::string_view data);
+
+    //! \brief Copy `data` to `dst` and add it, in one pass over the bytes
+    void copy_and_add(char *dst, std::string_view data);
+
+    //! \brief Add `len` bytes by their partial sum, as returned by partial() after adding just those bytes
+    void add_partial(const uint16_t partial_sum, const size_t len);
+
+    //! \name Add the bytes of Buffers by their Buffer::partial_sum(), which is computed only if it is not known
+    //!@{
+    void add_buffer(const Buffer &buffer) { add_partial(buffer.partial_sum(), buffer.size()); }
+    void add_buffers(const BufferList &buffers);
+    //!@}
+
     uint16_t value() const;
+
+    //! \brief The sum of the bytes added so far, before it is complemented: a partial sum for add_partial(),
+    //! or an `initial_sum` to continue from (if an even number of bytes was added)
+    uint16_t partial() const;
+
+    //! \name Incremental update ([RFC 1624](https://tools.ietf.org/html/rfc1624))
+    //! A field at an even offset in the checksummed data changed from `old_value` to `new_value`: the returned
+    //! checksum is what value() would give for the new data, without summing it again. A one-byte field is
+    //! updated as the 16-bit word that holds it.
+    //!@{
+    static uint16_t update_u16(const uint16_t checksum, const uint16_t old_value, const uint16_t new_value);
+    static uint16_t update_u32(const uint16_t checksum, const uint32_t old_value, const uint32_t new_value);
+    //!@}
 };
 
 //! Hexdump the contents of a packet (or any other sequence of bytes)
@@ -0,0 +1,309 @@
+#include "byte_stream.hh"
+#include "parser.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+static size_t allocations = 0;
+
+void *operator new(size_t size) {
+    allocations++;
+    void *ptr = malloc(size ? size : 1);
+    if (not ptr) {
+        throw bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept { free(ptr); }
+
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+
+//! The checksum one byte at a time, as RFC 1071 defines it
+static uint16_t reference_checksum(const string_view data) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < data.size(); i++) {
+        const uint64_t byte = static_cast<uint8_t>(data[i]);
+        sum += i % 2 == 0 ? byte << 8 : byte;
+    }
+    while (sum > 0xffff) {
+        sum = (sum >> 16) + (sum & 0xffff);
+    }
+    return ~sum;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        uniform_int_distribution<int> byte_dist{0, 255};
+
+        // Enough data for the AVX2 path to empty its lanes more than once
+        string data(3 << 20, '\0');
+        for (char &c : data) {
+            c = static_cast<char>(byte_dist(rd));
+        }
+
+        // Lengths and alignments at and around each path's block sizes
+        for (size_t len = 0; len < 300; len++) {
+            for (size_t offset = 0; offset < 8; offset++) {
+                const string_view piece{data.data() + offset, len};
+                InternetChecksum check;
+                check.add(piece);
+                if (check.value() != reference_checksum(piece)) {
+                    throw runtime_error("wrong checksum of " + to_string(len) + " bytes at offset " +
+                                        to_string(offset));
+                }
+            }
+        }
+
+        // Data split across add() calls at odd and even points
+        for (unsigned int trial = 0; trial < 2000; trial++) {
+            const size_t len = uniform_int_distribution<size_t>{0, trial < 10 ? data.size() : 4000}(rd);
+            const string_view all{data.data(), len};
+            InternetChecksum check;
+            for (size_t done = 0; done < len;) {
+                const size_t piece = min(len - done, uniform_int_distribution<size_t>{0, 100}(rd));
+                check.add(all.substr(done, piece));
+                done += piece;
+            }
+            if (check.value() != reference_checksum(all)) {
+                throw runtime_error("wrong checksum of " + to_string(len) + " bytes added in pieces");
+            }
+        }
+
+        // Partial sums of pieces combine into the sum of the whole, whatever the pieces' alignment
+        for (unsigned int trial = 0; trial < 2000; trial++) {
+            const size_t len = uniform_int_distribution<size_t>{0, 4000}(rd);
+            const string_view all{data.data(), len};
+            InternetChecksum check{0x1234};
+            InternetChecksum reference{0x1234};
+            for (size_t done = 0; done < len;) {
+                const size_t piece = min(len - done, uniform_int_distribution<size_t>{0, 100}(rd));
+                InternetChecksum piece_check;
+                piece_check.add(all.substr(done, piece));
+                check.add_partial(piece_check.partial(), piece);
+                reference.add(all.substr(done, piece));
+                done += piece;
+            }
+            if (check.value() != reference.value()) {
+                throw runtime_error("partial sums of " + to_string(len) + " bytes did not combine");
+            }
+        }
+
+        // Copying while adding gives the bytes and the sum of copying, then adding
+        for (unsigned int trial = 0; trial < 2000; trial++) {
+            const size_t len = uniform_int_distribution<size_t>{0, trial < 10 ? data.size() : 4000}(rd);
+            const size_t offset = trial % 8;
+            const string_view all{data.data() + offset, len};
+            string copy(len + 8, '\0');
+            InternetChecksum check;
+            for (size_t done = 0; done < len;) {
+                const size_t piece = min(len - done, uniform_int_distribution<size_t>{0, 300}(rd));
+                check.copy_and_add(copy.data() + (trial / 8) % 8 + done, all.substr(done, piece));
+                done += piece;
+            }
+            if (string_view{copy}.substr((trial / 8) % 8, len) != all or check.value() != reference_checksum(all)) {
+                throw runtime_error("copying and adding " + to_string(len) + " bytes went wrong");
+            }
+        }
+
+        // A read that spans writes is checksummed as it is copied
+        {
+            ByteStream stream{10000};
+            stream.write(data.substr(0, 1001));
+            stream.write(data.substr(1001, 999));
+            stream.write(data.substr(2000, 3000));
+            const Buffer spanning = stream.read_buffer_and_checksum(2500);
+            const Buffer slice = stream.read_buffer_and_checksum(2500);
+            if (spanning.str() != string_view{data}.substr(0, 2500) or
+                spanning.partial_sum() != Buffer{data.substr(0, 2500)}.partial_sum() or
+                slice.str() != string_view{data}.substr(2500, 2500) or
+                slice.partial_sum() != Buffer{data.substr(2500, 2500)}.partial_sum()) {
+                throw runtime_error("a read from a ByteStream has the wrong bytes or sum");
+            }
+        }
+
+        // A Buffer's kept sum follows it as it is trimmed from either end, and does not change its copies. Sums are
+        // compared by the checksums they give, as a ones-complement zero may come out as either 0 or 0xffff.
+        const auto checksum = [](const string_view bytes) {
+            InternetChecksum check{0x1234};
+            check.add(bytes);
+            return check.value();
+        };
+        const auto checksum_of_buffer = [](const Buffer &buffer) {
+            InternetChecksum check{0x1234};
+            check.add_buffer(buffer);
+            return check.value();
+        };
+        for (unsigned int trial = 0; trial < 2000; trial++) {
+            const size_t len = uniform_int_distribution<size_t>{1, 3000}(rd);
+            Buffer buffer{data.substr(trial, len)};
+            if (trial % 4 != 0) {
+                buffer.partial_sum();
+            }
+            const Buffer copy = buffer;
+            const size_t prefix = uniform_int_distribution<size_t>{0, trial % 2 ? len : len / 8}(rd);
+            const size_t suffix = uniform_int_distribution<size_t>{0, (len - prefix) / (trial % 3 + 1)}(rd);
+            buffer.remove_prefix(prefix);
+            buffer.remove_suffix(suffix);
+            const string_view trimmed = string_view{data}.substr(trial + prefix, len - prefix - suffix);
+            if (checksum_of_buffer(buffer) != checksum(trimmed) or
+                checksum_of_buffer(copy) != checksum(string_view{data}.substr(trial, len))) {
+                throw runtime_error("the sum of a Buffer trimmed to " + to_string(len - prefix - suffix) +
+                                    " bytes is wrong");
+            }
+        }
+
+        // A BufferList is summed piece by piece, whatever the pieces' alignment
+        for (unsigned int trial = 0; trial < 500; trial++) {
+            BufferList list;
+            for (size_t done = 0, pieces = trial % 6; pieces > 0; pieces--) {
+                const size_t piece = uniform_int_distribution<size_t>{0, 200}(rd);
+                Buffer buffer{data.substr(done, piece)};
+                if (trial % 2) {
+                    buffer.partial_sum();
+                }
+                list.append(buffer);
+                done += piece;
+            }
+            InternetChecksum check{0x1234};
+            check.add_buffers(list);
+            if (check.value() != checksum(list.concatenate())) {
+                throw runtime_error("wrong checksum of a BufferList of " + to_string(list.buffers().size()));
+            }
+        }
+
+        // RFC 1624: updating a checksum for a changed field matches summing the changed data again
+        for (unsigned int trial = 0; trial < 2000; trial++) {
+            string packet = data.substr(trial * 64, uniform_int_distribution<size_t>{8, 64}(rd));
+            InternetChecksum before;
+            before.add(packet);
+
+            const size_t word = uniform_int_distribution<size_t>{0, packet.size() / 4 - 1}(rd);
+            const uint32_t old_value = (uint32_t{static_cast<uint8_t>(packet[4 * word])} << 24) |
+                                       (uint32_t{static_cast<uint8_t>(packet[4 * word + 1])} << 16) |
+                                       (uint32_t{static_cast<uint8_t>(packet[4 * word + 2])} << 8) |
+                                       static_cast<uint8_t>(packet[4 * word + 3]);
+            const uint32_t new_value = trial % 2 ? ~old_value : static_cast<uint32_t>(rd());
+            for (size_t i = 0; i < 4; i++) {
+                packet[4 * word + i] = static_cast<char>(new_value >> (24 - 8 * i));
+            }
+            InternetChecksum after;
+            after.add(packet);
+
+            const uint16_t high_updated =
+                InternetChecksum::update_u16(before.value(), old_value >> 16, new_value >> 16);
+            if (InternetChecksum::update_u32(before.value(), old_value, new_value) != after.value() or
+                InternetChecksum::update_u16(high_updated, old_value & 0xffff, new_value & 0xffff) != after.value()) {
+                throw runtime_error("incremental checksum update disagrees with recomputation");
+            }
+        }
+
+        // A segment serialized again after a header change, with its payload sum reused, matches a fresh one
+        {
+            TCPSegment seg;
+            seg.header().seqno = WrappingInt32{1000};
+            seg.payload() = Buffer{data.substr(0, 1452)};
+            seg.serialize(0x4321);
+
+            seg.header().seqno = WrappingInt32{2000};
+            seg.header().ackno = WrappingInt32{3000};
+            seg.header().ack = true;
+            seg.header().win = 500;
+            TCPSegment fresh;
+            fresh.header() = seg.header();
+            fresh.payload() = Buffer{data.substr(0, 1452)};
+            if (seg.serialize(0x4321).concatenate() != fresh.serialize(0x4321).concatenate()) {
+                throw runtime_error("a reserialized segment differs from a fresh one");
+            }
+
+            // New bytes in the payload are summed again
+            seg.payload() = Buffer{data.substr(1, 1452)};
+            TCPSegment other;
+            other.header() = seg.header();
+            other.payload() = Buffer{data.substr(1, 1452)};
+            const string reserialized = seg.serialize(0x4321).concatenate();
+            if (reserialized != other.serialize(0x4321).concatenate()) {
+                throw runtime_error("a segment with a new payload kept the old payload's sum");
+            }
+            TCPSegment parsed;
+            if (parsed.parse(Buffer{string{reserialized}}, 0x4321) != ParseResult::NoError) {
+                throw runtime_error("a reserialized segment has a bad checksum");
+            }
+
+            // A parsed segment's payload inherits the sum taken to check it, and is forwarded unchanged
+            if (parsed.serialize(0x4321).concatenate() != reserialized) {
+                throw runtime_error("a parsed segment does not serialize as it was received");
+            }
+        }
+
+        // A header is serialized into memory of our own without allocating, and summed as it is written, options
+        // at odd offsets (after an odd-length Fast Open cookie) included
+        for (unsigned int trial = 0; trial < 1000; trial++) {
+            TCPHeader header;
+            header.sport = static_cast<uint16_t>(rd());
+            header.dport = static_cast<uint16_t>(rd());
+            header.seqno = WrappingInt32{static_cast<uint32_t>(rd())};
+            header.ackno = WrappingInt32{static_cast<uint32_t>(rd())};
+            header.ack = trial % 2;
+            header.syn = trial % 3 == 0;
+            header.win = static_cast<uint16_t>(rd());
+            header.cksum = static_cast<uint16_t>(rd());
+            (trial % 4 == 0) and (header.mss = static_cast<uint16_t>(rd()));
+            header.sack_permitted = trial % 5 == 0;
+            (trial % 6 == 0) and (header.window_scale = static_cast<uint8_t>(trial % 15));
+            (trial % 7 < 3) and (header.timestamps = TCPTimestamps{static_cast<uint32_t>(rd()), trial});
+            (trial % 8 == 0) and (header.fastopen_cookie = data.substr(trial, trial % 17));
+            for (size_t i = 0; i < trial % 5; i++) {
+                header.sack_blocks.push_back({WrappingInt32{static_cast<uint32_t>(rd())}, WrappingInt32{trial}});
+            }
+            while (TCPHeader::LENGTH + header.options_length() > TCPHeader::MAX_LENGTH) {
+                header.sack_blocks.pop_back();
+            }
+
+            TCPHeader::Bytes out;
+            InternetChecksum check{0x1234};
+            const size_t before = allocations;
+            const size_t length = header.serialize_into(out, check);
+            if (allocations != before) {
+                throw runtime_error("serializing a header into memory of our own allocated");
+            }
+
+            const string serialized{reinterpret_cast<const char *>(out.data()), length};
+            InternetChecksum reference{0x1234};
+            reference.add(serialized);
+            header.doff = length / 4;
+            TCPHeader parsed;
+            NetParser p{Buffer{string{serialized}}};
+            if (serialized != header.serialize() or check.value() != reference.value() or
+                parsed.parse(p) != ParseResult::NoError or not(parsed == header)) {
+                throw runtime_error("a header serialized into memory of our own is wrong or summed wrong");
+            }
+        }
+
+        // All ones, the worst case for carries
+        const string ones(1 << 20, '\xff');
+        InternetChecksum check;
+        check.add(ones);
+        if (check.value() != reference_checksum(ones)) {
+            throw runtime_error("wrong checksum of all ones");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -13,6 +13,7 @@
 #include <optional>
 #include <sstream>
 #include <string>
+#include <vector>
 
 struct ReceiverTestStep {
     virtual std::string to_string() const { return "ReceiverTestStep"; }
@@ -84,6 +85,136 @@ struct ExpectWindow : public ReceiverExpectation {
     }
 };
 
+struct ExpectWindowAdvertisement : public ReceiverExpectation {
+    uint16_t _win;
+
+    ExpectWindowAdvertisement(const uint16_t win) : _win(win) {}
+    std::string description() const { return "window advertisement " + std::to_string(_win); }
+
+    void execute(TCPReceiver &receiver) const {
+        if (receiver.window_advertisement() != _win) {
+            std::string reported = std::to_string(receiver.window_advertisement());
+            std::string expected = std::to_string(_win);
+            throw ReceiverExpectationViolation("The TCPReceiver reported window advertisement `" + reported +
+                                               "`, but it was expected to be `" + expected + "`");
+        }
+    }
+};
+
+struct ExpectAdvertisedWindow : public ReceiverExpectation {
+    size_t _window;
+
+    ExpectAdvertisedWindow(const size_t window) : _window(window) {}
+    std::string description() const { return "advertised window " + std::to_string(_window); }
+
+    void execute(TCPReceiver &receiver) const {
+        if (receiver.advertised_window() != _window) {
+            throw ReceiverExpectationViolation("The TCPReceiver reported an advertised window of " +
+                                               std::to_string(receiver.advertised_window()) +
+                                               ", but it was expected to be " + std::to_string(_window));
+        }
+    }
+};
+
+struct ExpectWindowUpdateDue : public ReceiverExpectation {
+    bool _due;
+
+    ExpectWindowUpdateDue(bool due) : _due(due) {}
+    std::string description() const { return std::string("window update ") + (_due ? "due" : "not due"); }
+
+    void execute(TCPReceiver &receiver) const {
+        if (receiver.window_update_due() != _due) {
+            throw ReceiverExpectationViolation(std::string("The TCPReceiver reported a window update ") +
+                                               (receiver.window_update_due() ? "due" : "not due") +
+                                               ", but it was expected to be " + (_due ? "due" : "not due"));
+        }
+    }
+};
+
+struct ExpectTsRecent : public ReceiverExpectation {
+    std::optional<uint32_t> _ts_recent;
+
+    ExpectTsRecent(std::optional<uint32_t> ts_recent) : _ts_recent(ts_recent) {}
+    std::string description() const {
+        return "TS.Recent " + (_ts_recent.has_value() ? std::to_string(_ts_recent.value()) : "none");
+    }
+
+    void execute(TCPReceiver &receiver) const {
+        if (receiver.ts_recent() != _ts_recent) {
+            std::string reported =
+                receiver.ts_recent().has_value() ? std::to_string(receiver.ts_recent().value()) : "none";
+            std::string expected = _ts_recent.has_value() ? std::to_string(_ts_recent.value()) : "none";
+            throw ReceiverExpectationViolation("The TCPReceiver reported TS.Recent `" + reported +
+                                               "`, but it was expected to be `" + expected + "`");
+        }
+    }
+};
+
+struct ExpectEce : public ReceiverExpectation {
+    bool _ece;
+
+    ExpectEce(bool ece) : _ece(ece) {}
+    std::string description() const { return std::string("ECE ") + (_ece ? "set" : "clear"); }
+
+    void execute(TCPReceiver &receiver) const {
+        if (receiver.ece() != _ece) {
+            throw ReceiverExpectationViolation(std::string("The TCPReceiver reported ECE ") +
+                                               (receiver.ece() ? "set" : "clear") + ", but it was expected to be " +
+                                               (_ece ? "set" : "clear"));
+        }
+    }
+};
+
+struct ExpectAckDue : public ReceiverExpectation {
+    bool _due;
+
+    ExpectAckDue(bool due) : _due(due) {}
+    std::string description() const { return std::string("ACK ") + (_due ? "due" : "not due"); }
+
+    void execute(TCPReceiver &receiver) const {
+        if (receiver.ack_due() != _due) {
+            throw ReceiverExpectationViolation(std::string("The TCPReceiver reported an ACK ") +
+                                               (receiver.ack_due() ? "due" : "not due") +
+                                               ", but it was expected to be " + (_due ? "due" : "not due"));
+        }
+    }
+};
+
+struct ExpectAckDeadline : public ReceiverExpectation {
+    std::optional<uint64_t> _deadline;
+
+    ExpectAckDeadline(std::optional<uint64_t> deadline) : _deadline(deadline) {}
+    std::string description() const {
+        return "ACK deadline " + (_deadline.has_value() ? std::to_string(_deadline.value()) : "none");
+    }
+
+    void execute(TCPReceiver &receiver) const {
+        if (receiver.ack_deadline() != _deadline) {
+            std::string reported =
+                receiver.ack_deadline().has_value() ? std::to_string(receiver.ack_deadline().value()) : "none";
+            std::string expected = _deadline.has_value() ? std::to_string(_deadline.value()) : "none";
+            throw ReceiverExpectationViolation("The TCPReceiver reported ACK deadline `" + reported +
+                                               "`, but it was expected to be `" + expected + "`");
+        }
+    }
+};
+
+struct ExpectFastOpenCookie : public ReceiverExpectation {
+    std::optional<std::string> _cookie;
+
+    ExpectFastOpenCookie(std::optional<std::string> cookie) : _cookie(cookie) {}
+    std::string description() const {
+        return "Fast Open cookie " + (_cookie.has_value() ? "of " + std::to_string(_cookie.value().size()) + " bytes"
+                                                          : std::string("none"));
+    }
+
+    void execute(TCPReceiver &receiver) const {
+        if (receiver.fastopen_cookie() != _cookie) {
+            throw ReceiverExpectationViolation("The TCPReceiver reported the wrong Fast Open cookie");
+        }
+    }
+};
+
 struct ExpectUnassembledBytes : public ReceiverExpectation {
     size_t _n_bytes;
 
@@ -116,6 +247,32 @@ struct ExpectTotalAssembledBytes : public ReceiverExpectation {
     }
 };
 
+struct ExpectSackBlocks : public ReceiverExpectation {
+    std::vector<TCPSACKBlock> _blocks;
+
+    ExpectSackBlocks(std::vector<TCPSACKBlock> blocks) : _blocks(std::move(blocks)) {}
+    std::string description() const {
+        std::ostringstream ss;
+        ss << _blocks.size() << " SACK blocks:";
+        for (const auto &block : _blocks) {
+            ss << " " << block.left << "-" << block.right;
+        }
+        return ss.str();
+    }
+
+    void execute(TCPReceiver &receiver) const {
+        if (receiver.sack_blocks() != _blocks) {
+            std::ostringstream ss;
+            ss << "The TCPReceiver reported SACK blocks";
+            for (const auto &block : receiver.sack_blocks()) {
+                ss << " " << block.left << "-" << block.right;
+            }
+            ss << ", but was expected to report " << description();
+            throw ReceiverExpectationViolation(ss.str());
+        }
+    }
+};
+
 struct ExpectEof : public ReceiverExpectation {
     ExpectEof() {}
     std::string description() const { return "receiver.stream_out().eof() == true"; }
@@ -192,6 +349,13 @@ struct SegmentArrives : public ReceiverAction {
     bool rst{};
     bool syn{};
     bool fin{};
+    bool ece{};
+    bool cwr{};
+    bool ce{};
+    bool sack_permitted{};
+    std::optional<uint8_t> window_scale{};
+    std::optional<TCPTimestamps> timestamps{};
+    std::optional<std::string> fastopen_cookie{};
     WrappingInt32 seqno{0};
     WrappingInt32 ackno{0};
     uint16_t win{};
@@ -221,6 +385,42 @@ struct SegmentArrives : public ReceiverAction {
         return *this;
     }
 
+    SegmentArrives &with_ece() {
+        ece = true;
+        return *this;
+    }
+
+    SegmentArrives &with_cwr() {
+        cwr = true;
+        return *this;
+    }
+
+    //! The path marked the segment Congestion Experienced
+    SegmentArrives &with_ce() {
+        ce = true;
+        return *this;
+    }
+
+    SegmentArrives &with_sack_permitted() {
+        sack_permitted = true;
+        return *this;
+    }
+
+    SegmentArrives &with_window_scale(uint8_t shift) {
+        window_scale = shift;
+        return *this;
+    }
+
+    SegmentArrives &with_timestamps(uint32_t tsval, uint32_t tsecr) {
+        timestamps = TCPTimestamps{tsval, tsecr};
+        return *this;
+    }
+
+    SegmentArrives &with_fastopen_cookie(const std::string &cookie) {
+        fastopen_cookie = cookie;
+        return *this;
+    }
+
     SegmentArrives &with_seqno(WrappingInt32 seqno_) {
         seqno = seqno_;
         return *this;
@@ -250,6 +450,13 @@ struct SegmentArrives : public ReceiverAction {
         seg.header().fin = fin;
         seg.header().syn = syn;
         seg.header().rst = rst;
+        seg.header().ece = ece;
+        seg.header().cwr = cwr;
+        seg.ce() = ce;
+        seg.header().sack_permitted = sack_permitted;
+        seg.header().window_scale = window_scale;
+        seg.header().timestamps = timestamps;
+        seg.header().fastopen_cookie = fastopen_cookie;
         seg.header().ackno = ackno;
         seg.header().seqno = seqno;
         seg.header().win = win;
@@ -293,6 +500,38 @@ struct SegmentArrives : public ReceiverAction {
     }
 };
 
+struct EnableFastOpen : public ReceiverAction {
+    TCPFastOpenKey _key;
+    Address _client;
+
+    EnableFastOpen(const TCPFastOpenKey &key, const Address &client) : _key(key), _client(client) {}
+    std::string description() const override { return "enable Fast Open for " + _client.ip(); }
+    void execute(TCPReceiver &receiver) const override { receiver.enable_fastopen(_key, _client); }
+};
+
+//! The application reads (and discards) bytes from the receiver's stream
+struct ReadBytes : public ReceiverAction {
+    size_t _len;
+
+    ReadBytes(const size_t len) : _len(len) {}
+    std::string description() const override { return "read " + std::to_string(_len) + " bytes"; }
+    void execute(TCPReceiver &receiver) const override { receiver.stream_out().pop_output(_len); }
+};
+
+//! The connection sent a segment carrying the receiver's ackno and window
+struct AckSent : public ReceiverAction {
+    std::string description() const override { return "ACK sent"; }
+    void execute(TCPReceiver &receiver) const override { receiver.ack_sent(); }
+};
+
+struct TimePasses : public ReceiverAction {
+    size_t _ms;
+
+    TimePasses(const size_t ms) : _ms(ms) {}
+    std::string description() const override { return std::to_string(_ms) + " ms pass"; }
+    void execute(TCPReceiver &receiver) const override { receiver.tick(_ms); }
+};
+
 class TCPReceiverTestHarness {
     TCPReceiver receiver;
     std::vector<std::string> steps_executed;
@@ -304,6 +543,12 @@ class TCPReceiverTestHarness {
            << "capacity=" << capacity << ")";
         steps_executed.emplace_back(ss.str());
     }
+    TCPReceiverTestHarness(const TCPConfig &config) : receiver(config), steps_executed() {
+        std::ostringstream ss;
+        ss << "Initialized with ("
+           << "capacity=" << config.recv_capacity << ", window_scale=" << config.window_scale << ")";
+        steps_executed.emplace_back(ss.str());
+    }
     void execute(const ReceiverTestStep &step) {
         try {
             step.execute(receiver);
@@ -0,0 +1,124 @@
+#include "tcp_config.hh"
+#include "tcp_memory.hh"
+#include "tcp_receiver.hh"
+#include "test_utils.hh"
+#include "util.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static constexpr uint64_t RTT = 10;
+
+static void check(const bool ok, const string &what) {
+    if (not ok) {
+        throw runtime_error(what);
+    }
+}
+
+static void syn(TCPReceiver &receiver, const WrappingInt32 isn) {
+    TCPSegment seg;
+    seg.header().syn = true;
+    seg.header().seqno = isn;
+    receiver.segment_received(seg);
+    receiver.ack_sent();
+}
+
+//! Streams `rounds` round trips of data into `receiver`: each round the peer fills the advertised window with
+//! full-sized segments, the reader reads up to `read_per_round` bytes, an ACK is sent, and a round trip passes.
+//! Checks that every byte the window allowed was kept.
+static void stream(TCPReceiver &receiver, const WrappingInt32 isn, const unsigned rounds, const size_t read_per_round) {
+    for (unsigned round = 0; round < rounds; round++) {
+        const uint64_t next = receiver.stream_out().bytes_written();
+        const size_t window = receiver.advertised_window();
+        for (size_t offset = 0; offset < window; offset += TCPConfig::MAX_PAYLOAD_SIZE) {
+            TCPSegment seg;
+            seg.header().seqno = wrap(next + offset + 1, isn);
+            seg.payload() = Buffer{string(min(TCPConfig::MAX_PAYLOAD_SIZE, window - offset), 'x')};
+            receiver.segment_received(seg);
+        }
+        check(receiver.stream_out().bytes_written() == next + window, "data inside the window was dropped");
+        receiver.stream_out().pop_output(min(read_per_round, receiver.stream_out().buffer_size()));
+        receiver.ack_sent();
+        receiver.tick(RTT);
+    }
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        TCPConfig cfg;
+        cfg.recv_capacity = 4000;
+        cfg.max_recv_capacity = 200000;
+
+        {
+            // Without autotuning the capacity stays where it was configured
+            const WrappingInt32 isn(rd());
+            TCPReceiver receiver{cfg};
+            syn(receiver, isn);
+            stream(receiver, isn, 30, SIZE_MAX);
+            check(receiver.capacity() == 4000, "the capacity changed without autotuning");
+            check(receiver.advertised_window() == 4000, "the window changed without autotuning");
+        }
+
+        cfg.autotune = true;
+        check(cfg.window_shift() == 2, "the window scale does not cover the largest receive capacity");
+
+        {
+            // A reader that keeps up doubles the buffer every round trip, up to the maximum, and a reader that
+            // falls behind lets it shrink back to the configured capacity
+            const WrappingInt32 isn(rd());
+            TCPReceiver receiver{cfg};
+            syn(receiver, isn);
+            size_t previous = receiver.capacity();
+            for (unsigned round = 0; round < 12; round++) {
+                stream(receiver, isn, 1, SIZE_MAX);
+                check(receiver.capacity() >= previous, "the capacity shrank while the reader kept up");
+                previous = receiver.capacity();
+            }
+            check(receiver.capacity() == 200000, "the capacity did not grow to the maximum");
+            check(receiver.advertised_window() == 200000, "the window did not grow with the capacity");
+
+            TCPInfo info{};
+            receiver.fill_info(info);
+            check(info.rcv_capacity == 200000, "fill_info() does not report the capacity");
+
+            stream(receiver, isn, 200, 1000);
+            check(receiver.capacity() == 4000, "the capacity did not shrink back for a slow reader");
+            check(receiver.advertised_window() <= receiver.window_size(), "the window outgrew the buffer");
+        }
+
+        {
+            // Connections sharing a memory budget grow only as far as it allows, and give it back when destroyed
+            cfg.memory_budget = make_shared<TCPMemoryBudget>(50000);
+            {
+                const WrappingInt32 isn_a(rd());
+                const WrappingInt32 isn_b(rd());
+                TCPReceiver a{cfg};
+                TCPReceiver b{cfg};
+                syn(a, isn_a);
+                syn(b, isn_b);
+                for (unsigned round = 0; round < 20; round++) {
+                    stream(a, isn_a, 1, SIZE_MAX);
+                    stream(b, isn_b, 1, SIZE_MAX);
+                }
+                check(a.capacity() + b.capacity() == 2 * 4000 + 50000, "the budget was not used up");
+                check(cfg.memory_budget->used() == 50000, "the budget lost track of its shares");
+            }
+            check(cfg.memory_budget->used() == 0, "the shares were not returned");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,151 @@
+#include "tcp_info.hh"
+#include "tcp_receiver.hh"
+#include "util.hh"
+#include "wrapping_integers.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static TCPSegment data_segment(const WrappingInt32 seqno, const string &data, const bool fin = false) {
+    TCPSegment seg;
+    seg.header().ack = true;
+    seg.header().seqno = seqno;
+    seg.header().fin = fin;
+    seg.payload() = string(data);
+    return seg;
+}
+
+static TCPSegment syn_segment(const WrappingInt32 isn) {
+    TCPSegment seg;
+    seg.header().syn = true;
+    seg.header().seqno = isn;
+    return seg;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            // A batch that starts with the SYN, with data out of order and duplicated
+            const WrappingInt32 isn(rd());
+            TCPReceiver receiver{4000};
+            receiver.segments_received({data_segment(isn + 4, "def"),
+                                        syn_segment(isn),
+                                        data_segment(isn + 7, "ghi"),
+                                        data_segment(isn + 1, "abc"),
+                                        data_segment(isn + 4, "def"),
+                                        data_segment(isn + 10, "", true)});
+            if (receiver.ackno() != isn + 11 or receiver.stream_out().read(9) != "abcdefghi" or
+                not receiver.stream_out().input_ended()) {
+                throw runtime_error("the batch was not assembled");
+            }
+            TCPInfo info{};
+            receiver.fill_info(info);
+            if (info.segments_in != 6 or info.bytes_received != 12) {
+                throw runtime_error("the batch's segments were not all counted");
+            }
+        }
+
+        {
+            // In-order data in one batch is one ACK decision; a duplicate in the batch calls for an ACK at once
+            const WrappingInt32 isn(rd());
+            TCPConfig cfg;
+            cfg.ack_delay = 40;
+            cfg.ack_frequency = 4;
+            TCPReceiver receiver{cfg};
+            receiver.segment_received(syn_segment(isn));
+            receiver.ack_sent();
+            receiver.segments_received({data_segment(isn + 4, "def"), data_segment(isn + 1, "abc")});
+            if (receiver.ack_due() or receiver.ack_deadline() != 40) {
+                throw runtime_error("in-order data in one batch was not held for a delayed ACK");
+            }
+            receiver.segments_received({data_segment(isn + 7, "g"), data_segment(isn + 7, "g")});
+            if (not receiver.ack_due() or receiver.ackno() != isn + 8) {
+                throw runtime_error("a duplicate within a batch was not acknowledged at once");
+            }
+        }
+
+        {
+            // PAWS follows arrival order: a retransmission that fills a hole, with a newer TSval, does not make
+            // the data after the hole, sent earlier, look like an old duplicate
+            const WrappingInt32 isn(rd());
+            TCPConfig cfg;
+            cfg.timestamps = true;
+            const auto stamped = [](TCPSegment seg, const uint32_t tsval) {
+                seg.header().timestamps = TCPTimestamps{tsval, 0};
+                return seg;
+            };
+            TCPReceiver batched{cfg};
+            TCPReceiver serial{cfg};
+            const vector<TCPSegment> batch{stamped(data_segment(isn + 9, "cccc"), 20),
+                                           stamped(data_segment(isn + 5, "bbbb"), 30)};
+            for (TCPReceiver *receiver : {&batched, &serial}) {
+                receiver->segment_received(stamped(syn_segment(isn), 1));
+                receiver->segment_received(stamped(data_segment(isn + 1, "aaaa"), 10));
+            }
+            batched.segments_received(batch);
+            for (const auto &seg : batch) {
+                serial.segment_received(seg);
+            }
+            if (serial.ackno() != isn + 13 or batched.ackno() != serial.ackno() or
+                batched.ts_recent() != serial.ts_recent()) {
+                throw runtime_error("PAWS dropped data in a batch that it kept one segment at a time");
+            }
+        }
+
+        // Batches of shuffled, duplicated pieces of a stream assemble as the pieces would one by one
+        for (unsigned int round = 0; round < 200; round++) {
+            const WrappingInt32 isn(rd());
+            const size_t size = 1 + rd() % 3000;
+            string data(size, 0);
+            generate(data.begin(), data.end(), [&] { return static_cast<char>(rd()); });
+
+            vector<TCPSegment> pieces;
+            for (size_t offset = 0; offset < size;) {
+                const size_t len = min<size_t>(size - offset, 1 + rd() % 200);
+                pieces.push_back(data_segment(isn + 1 + offset, data.substr(offset, len), offset + len == size));
+                offset += len;
+            }
+            for (size_t i = 0, copies = rd() % 10; i < copies; i++) {
+                pieces.push_back(pieces[rd() % pieces.size()]);
+            }
+            shuffle(pieces.begin(), pieces.end(), rd);
+
+            TCPReceiver batched{4000};
+            TCPReceiver serial{4000};
+            batched.segment_received(syn_segment(isn));
+            serial.segment_received(syn_segment(isn));
+            for (size_t first = 0; first < pieces.size();) {
+                const size_t count = min<size_t>(pieces.size() - first, 1 + rd() % 16);
+                const vector<TCPSegment> batch(pieces.begin() + first, pieces.begin() + first + count);
+                batched.segments_received(batch);
+                for (const auto &seg : batch) {
+                    serial.segment_received(seg);
+                }
+                if (batched.ackno() != serial.ackno() or batched.window_size() != serial.window_size() or
+                    batched.unassembled_bytes() != serial.unassembled_bytes()) {
+                    throw runtime_error("a batch left the receiver in a different state");
+                }
+                first += count;
+            }
+            if (batched.stream_out().read(size) != data or not batched.stream_out().input_ended()) {
+                throw runtime_error("the batches did not assemble the stream");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
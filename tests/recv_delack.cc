@@ -0,0 +1,156 @@
+#include "receiver_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const string full(TCPConfig::MAX_PAYLOAD_SIZE, 'x');
+
+        {
+            // Without a delay, every segment that occupies sequence space is acknowledged
+            TCPConfig cfg;
+            uint32_t isn = rd();
+            TCPReceiverTestHarness test{cfg};
+            test.execute(ExpectAckDue{false});
+            test.execute(SegmentArrives{}.with_syn().with_seqno(isn));
+            test.execute(ExpectAckDue{true});
+            test.execute(AckSent{});
+            test.execute(ExpectAckDue{false});
+            test.execute(SegmentArrives{}.with_seqno(isn + 1).with_data("a"));
+            test.execute(ExpectAckDue{true});
+            test.execute(AckSent{});
+            test.execute(SegmentArrives{}.with_ack(1).with_seqno(isn + 2));
+            test.execute(ExpectAckDue{false});
+            test.execute(ExpectAckDeadline{nullopt});
+        }
+
+        {
+            // Every second full-sized segment is acknowledged, and a lone one after the delay
+            TCPConfig cfg;
+            cfg.ack_delay = 40;
+            uint32_t isn = rd();
+            TCPReceiverTestHarness test{cfg};
+            test.execute(SegmentArrives{}.with_syn().with_seqno(isn));
+            test.execute(ExpectAckDue{true});
+            test.execute(AckSent{});
+
+            test.execute(TimePasses{5});
+            test.execute(SegmentArrives{}.with_seqno(isn + 1).with_data(full));
+            test.execute(ExpectAckDue{false});
+            test.execute(ExpectAckDeadline{45});
+            test.execute(SegmentArrives{}.with_seqno(isn + 1 + full.size()).with_data(full));
+            test.execute(ExpectAckDue{true});
+            test.execute(AckSent{});
+            test.execute(ExpectAckDeadline{nullopt});
+
+            test.execute(SegmentArrives{}.with_seqno(isn + 1 + 2 * full.size()).with_data(full));
+            test.execute(TimePasses{39});
+            test.execute(ExpectAckDue{false});
+            test.execute(TimePasses{1});
+            test.execute(ExpectAckDue{true});
+            test.execute(AckSent{});
+
+            // Small segments count by bytes
+            test.execute(SegmentArrives{}.with_seqno(isn + 1 + 3 * full.size()).with_data("abc"));
+            test.execute(ExpectAckDue{false});
+            test.execute(ExpectAckDeadline{85});
+        }
+
+        {
+            // Out-of-order data, the segment that fills the hole, duplicates and FIN are acknowledged at once
+            TCPConfig cfg;
+            cfg.ack_delay = 40;
+            uint32_t isn = rd();
+            TCPReceiverTestHarness test{cfg};
+            test.execute(SegmentArrives{}.with_syn().with_seqno(isn));
+            test.execute(AckSent{});
+            test.execute(SegmentArrives{}.with_seqno(isn + 4).with_data("def"));
+            test.execute(ExpectAckDue{true});
+            test.execute(AckSent{});
+            test.execute(SegmentArrives{}.with_seqno(isn + 1).with_data("abc"));
+            test.execute(ExpectAckDue{true});
+            test.execute(AckSent{});
+            test.execute(SegmentArrives{}.with_seqno(isn + 1).with_data("abc"));
+            test.execute(ExpectAckDue{true});
+            test.execute(AckSent{});
+            test.execute(SegmentArrives{}.with_seqno(isn + 7).with_data("g"));
+            test.execute(ExpectAckDue{false});
+            test.execute(SegmentArrives{}.with_seqno(isn + 8).with_fin());
+            test.execute(ExpectAckDue{true});
+        }
+
+        {
+            // A higher ACK frequency decimates further
+            TCPConfig cfg;
+            cfg.ack_delay = 40;
+            cfg.ack_frequency = 4;
+            cfg.recv_capacity = 64000;
+            uint32_t isn = rd();
+            TCPReceiverTestHarness test{cfg};
+            test.execute(SegmentArrives{}.with_syn().with_seqno(isn));
+            test.execute(AckSent{});
+            for (size_t i = 0; i < 4; i++) {
+                test.execute(ExpectAckDue{false});
+                test.execute(SegmentArrives{}.with_seqno(isn + 1 + i * full.size()).with_data(full));
+            }
+            test.execute(ExpectAckDue{true});
+        }
+
+        {
+            // The window opening to twice what the peer was told is announced at once
+            TCPConfig cfg;
+            cfg.ack_delay = 40;
+            cfg.recv_capacity = 4000;
+            uint32_t isn = rd();
+            TCPReceiverTestHarness test{cfg};
+            test.execute(SegmentArrives{}.with_syn().with_seqno(isn));
+            test.execute(SegmentArrives{}.with_seqno(isn + 1).with_data(string(1000, 'a')));
+            test.execute(AckSent{});
+            test.execute(ExpectBytes{string(1000, 'a')});
+            test.execute(ExpectAckDue{false});
+
+            test.execute(SegmentArrives{}.with_seqno(isn + 1001).with_data(string(3000, 'b')));
+            test.execute(AckSent{});
+            test.execute(ExpectWindow{1000});
+            test.execute(ExpectAckDue{false});
+            test.execute(ExpectBytes{string(3000, 'b')});
+            test.execute(ExpectAckDue{true});
+        }
+
+        {
+            // With DCTCP, a change in the CE marks is echoed at once
+            TCPConfig cfg;
+            cfg.ack_delay = 40;
+            cfg.ecn = true;
+            cfg.dctcp = true;
+            uint32_t isn = rd();
+            TCPReceiverTestHarness test{cfg};
+            test.execute(SegmentArrives{}.with_syn().with_ece().with_cwr().with_seqno(isn));
+            test.execute(AckSent{});
+            test.execute(SegmentArrives{}.with_seqno(isn + 1).with_data("a"));
+            test.execute(ExpectAckDue{false});
+            test.execute(SegmentArrives{}.with_seqno(isn + 2).with_data("b").with_ce());
+            test.execute(ExpectEce{true});
+            test.execute(ExpectAckDue{true});
+            test.execute(AckSent{});
+            test.execute(SegmentArrives{}.with_seqno(isn + 3).with_data("c").with_ce());
+            test.execute(ExpectAckDue{false});
+            test.execute(SegmentArrives{}.with_seqno(isn + 4).with_data("d"));
+            test.execute(ExpectAckDue{true});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
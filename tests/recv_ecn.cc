@@ -0,0 +1,106 @@
+#include "receiver_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            // Without ECN negotiated, CE marks are not echoed
+            TCPConfig cfg;
+            cfg.ecn = true;
+            uint32_t isn = 500;
+            TCPReceiverTestHarness test{cfg};
+            test.execute(SegmentArrives{}.with_syn().with_seqno(isn));
+            test.execute(SegmentArrives{}.with_seqno(isn + 1).with_data("abc").with_ce());
+            test.execute(ExpectEce{false});
+        }
+
+        {
+            // Nor when we did not offer it
+            TCPConfig cfg;
+            uint32_t isn = 500;
+            TCPReceiverTestHarness test{cfg};
+            test.execute(SegmentArrives{}.with_syn().with_ece().with_cwr().with_seqno(isn));
+            test.execute(SegmentArrives{}.with_seqno(isn + 1).with_data("abc").with_ce());
+            test.execute(ExpectEce{false});
+        }
+
+        {
+            // A SYN asks for ECN only with both ECE and CWR, and a SYN-ACK agrees only with ECE alone
+            for (const bool ack : {false, true}) {
+                TCPConfig cfg;
+                cfg.ecn = true;
+                uint32_t isn = 500;
+                TCPReceiverTestHarness test{cfg};
+                SegmentArrives syn = SegmentArrives{}.with_syn().with_ece().with_seqno(isn);
+                if (ack) {
+                    syn.with_ack(1).with_cwr();
+                }
+                test.execute(syn);
+                test.execute(SegmentArrives{}.with_seqno(isn + 1).with_data("abc").with_ce());
+                test.execute(ExpectEce{false});
+            }
+        }
+
+        {
+            // A SYN-ACK with ECE alone agrees to ECN
+            TCPConfig cfg;
+            cfg.ecn = true;
+            uint32_t isn = 500;
+            TCPReceiverTestHarness test{cfg};
+            test.execute(SegmentArrives{}.with_syn().with_ack(1).with_ece().with_seqno(isn));
+            test.execute(SegmentArrives{}.with_seqno(isn + 1).with_data("abc").with_ce());
+            test.execute(ExpectEce{true});
+        }
+
+        {
+            // Classic ECN: ECE is set by a mark and stays set until the sender answers with CWR
+            TCPConfig cfg;
+            cfg.ecn = true;
+            uint32_t isn = 500;
+            TCPReceiverTestHarness test{cfg};
+            test.execute(SegmentArrives{}.with_syn().with_ece().with_cwr().with_seqno(isn));
+            test.execute(ExpectEce{false});
+            test.execute(SegmentArrives{}.with_seqno(isn + 1).with_data("abc").with_ce());
+            test.execute(ExpectEce{true});
+            test.execute(SegmentArrives{}.with_seqno(isn + 4).with_data("def"));
+            test.execute(ExpectEce{true});
+            test.execute(SegmentArrives{}.with_seqno(isn + 7).with_data("ghi").with_cwr());
+            test.execute(ExpectEce{false});
+            // A mark on the CWR segment itself is a new one.
+            test.execute(SegmentArrives{}.with_seqno(isn + 10).with_data("jkl").with_cwr().with_ce());
+            test.execute(ExpectEce{true});
+            test.execute(ExpectBytes{"abcdefghijkl"});
+        }
+
+        {
+            // DCTCP: ECE reflects the mark on each segment
+            TCPConfig cfg;
+            cfg.ecn = true;
+            cfg.dctcp = true;
+            uint32_t isn = 500;
+            TCPReceiverTestHarness test{cfg};
+            test.execute(SegmentArrives{}.with_syn().with_ece().with_cwr().with_seqno(isn));
+            test.execute(SegmentArrives{}.with_seqno(isn + 1).with_data("abc").with_ce());
+            test.execute(ExpectEce{true});
+            test.execute(SegmentArrives{}.with_seqno(isn + 4).with_data("def"));
+            test.execute(ExpectEce{false});
+            test.execute(SegmentArrives{}.with_seqno(isn + 7).with_data("ghi").with_ce());
+            test.execute(ExpectEce{true});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
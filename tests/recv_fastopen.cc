@@ -0,0 +1,101 @@
+#include "receiver_harness.hh"
+#include "tcp_fastopen.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        const TCPFastOpenKey key{};
+        const Address client{"10.0.0.2", 5000};
+        const string cookie = key.cookie(client);
+
+        {
+            // Cookies are a keyed hash of the client's IP address alone
+            if (cookie.size() != TCPFastOpenKey::COOKIE_LENGTH or key.cookie(Address{"10.0.0.2", 6000}) != cookie) {
+                throw runtime_error("a client's cookie should not depend on its port");
+            }
+            if (key.cookie(Address{"10.0.0.3", 5000}) == cookie) {
+                throw runtime_error("different clients should get different cookies");
+            }
+            if (TCPFastOpenKey{1, 2}.cookie(client) != TCPFastOpenKey{1, 2}.cookie(client) or
+                TCPFastOpenKey{1, 2}.cookie(client) == TCPFastOpenKey{1, 3}.cookie(client)) {
+                throw runtime_error("cookies should be determined by the key");
+            }
+
+            TCPFastOpenCache cache;
+            cache.insert(Address{"10.0.0.1", 80}, cookie);
+            if (cache.cookie(Address{"10.0.0.1", 443}) != cookie or cache.cookie(client).has_value()) {
+                throw runtime_error("the cookie cache should be keyed by the server's IP address");
+            }
+            cache.erase(Address{"10.0.0.1", 80});
+            if (cache.cookie(Address{"10.0.0.1", 80}).has_value()) {
+                throw runtime_error("an erased cookie should be gone");
+            }
+        }
+
+        {
+            // A valid cookie lets the data on the SYN through before the handshake completes
+            uint32_t isn = 3000;
+            TCPReceiverTestHarness test{4000};
+            test.execute(EnableFastOpen{key, client});
+            test.execute(SegmentArrives{}.with_syn().with_seqno(isn).with_fastopen_cookie(cookie).with_data("hello"));
+            test.execute(ExpectAckno{WrappingInt32{isn + 6}});
+            test.execute(ExpectBytes{"hello"});
+            test.execute(ExpectFastOpenCookie{nullopt});
+        }
+
+        {
+            // A cookie request is answered, and the data on that SYN is not accepted
+            uint32_t isn = 3000;
+            TCPReceiverTestHarness test{4000};
+            test.execute(EnableFastOpen{key, client});
+            test.execute(SegmentArrives{}.with_syn().with_seqno(isn).with_fastopen_cookie("").with_data("hello"));
+            test.execute(ExpectAckno{WrappingInt32{isn + 1}});
+            test.execute(ExpectTotalAssembledBytes{0});
+            test.execute(ExpectFastOpenCookie{cookie});
+
+            // The client sends the data again once the handshake completes.
+            test.execute(SegmentArrives{}.with_seqno(isn + 1).with_data("hello"));
+            test.execute(ExpectBytes{"hello"});
+        }
+
+        {
+            // A stale cookie is replaced, and a FIN on that SYN is dropped with its data
+            uint32_t isn = 3000;
+            TCPReceiverTestHarness test{4000};
+            test.execute(EnableFastOpen{key, client});
+            test.execute(SegmentArrives{}
+                             .with_syn()
+                             .with_fin()
+                             .with_seqno(isn)
+                             .with_fastopen_cookie(TCPFastOpenKey{}.cookie(client))
+                             .with_data("hello"));
+            test.execute(ExpectAckno{WrappingInt32{isn + 1}});
+            test.execute(ExpectInputNotEnded{});
+            test.execute(ExpectFastOpenCookie{cookie});
+        }
+
+        {
+            // Without Fast Open enabled, data on a SYN is accepted as before, and no cookie is issued
+            uint32_t isn = 3000;
+            TCPReceiverTestHarness test{4000};
+            test.execute(SegmentArrives{}.with_syn().with_seqno(isn).with_fastopen_cookie("").with_data("hello"));
+            test.execute(ExpectAckno{WrappingInt32{isn + 6}});
+            test.execute(ExpectFastOpenCookie{nullopt});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
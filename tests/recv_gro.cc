@@ -0,0 +1,156 @@
+#include "tcp_gro.hh"
+#include "tcp_info.hh"
+#include "tcp_receiver.hh"
+#include "util.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+static TCPSegment data_segment(const WrappingInt32 seqno, const string &data) {
+    TCPSegment seg;
+    seg.header().ack = true;
+    seg.header().ackno = WrappingInt32{1000};
+    seg.header().win = 5000;
+    seg.header().seqno = seqno;
+    seg.payload() = string(data);
+    return seg;
+}
+
+//! Push `segments` through a TCPGRO as one batch, and return the number of segments in each run
+static vector<size_t> runs(const vector<TCPSegment> &segments) {
+    TCPGRO gro;
+    for (const auto &seg : segments) {
+        gro.push(seg);
+    }
+    gro.flush();
+    vector<size_t> counts;
+    while (not gro.segments_out().empty()) {
+        counts.push_back(gro.segments_out().front().count());
+        gro.segments_out().pop();
+    }
+    return counts;
+}
+
+static void expect_runs(const string &name, const vector<TCPSegment> &segments, const vector<size_t> &expected) {
+    const auto counts = runs(segments);
+    if (counts != expected) {
+        string got;
+        for (const auto count : counts) {
+            got += " " + to_string(count);
+        }
+        throw runtime_error(name + ": runs of" + got);
+    }
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const WrappingInt32 isn(rd());
+
+        // A stream of full-sized segments, each with distinct bytes
+        vector<TCPSegment> stream;
+        string expected_bytes;
+        for (size_t i = 0; i < 10; i++) {
+            const string data(MSS, static_cast<char>('a' + i));
+            stream.push_back(data_segment(isn + 1 + i * MSS, data));
+            expected_bytes += data;
+        }
+
+        expect_runs("back-to-back segments", stream, {10});
+
+        {
+            auto segments = stream;
+            segments[2].header().psh = true;
+            expect_runs("PSH ends a run", segments, {3, 7});
+        }
+        {
+            auto segments = stream;
+            segments[3].payload().remove_suffix(1);
+            for (size_t i = 4; i < segments.size(); i++) {
+                segments[i].header().seqno = segments[i].header().seqno - 1;
+            }
+            expect_runs("a short segment ends a run", segments, {4, 6});
+        }
+        {
+            auto segments = stream;
+            for (size_t i = 5; i < segments.size(); i++) {
+                segments[i].header().seqno = segments[i].header().seqno + 1;
+            }
+            expect_runs("a gap ends a run", segments, {5, 5});
+        }
+        {
+            auto segments = stream;
+            for (size_t i = 5; i < segments.size(); i++) {
+                segments[i].header().win = 4000;
+                if (i >= 7) {
+                    segments[i].header().ackno = WrappingInt32{2000};
+                }
+            }
+            expect_runs("window and ackno changes end runs", segments, {5, 2, 3});
+        }
+        {
+            auto segments = stream;
+            segments[6].ce() = true;
+            segments[7].ce() = true;
+            segments[9].header().fin = true;
+            expect_runs("CE marks and FIN end runs", segments, {6, 2, 1, 1});
+        }
+        {
+            vector<TCPSegment> segments{stream[0], stream[1], data_segment(isn + 1 + 2 * MSS, ""), stream[2]};
+            segments[0].header().syn = true;
+            segments[0].header().seqno = isn;
+            expect_runs("SYN and pure ACKs are never merged", segments, {1, 1, 1, 1});
+        }
+
+        {
+            // The receiver takes a run as one segment, without copying its payloads
+            TCPConfig cfg;
+            cfg.ack_delay = 40;
+            TCPReceiver receiver{cfg};
+            TCPSegment syn;
+            syn.header().syn = true;
+            syn.header().seqno = isn;
+            receiver.segment_received(syn);
+            receiver.ack_sent();
+
+            TCPGRO gro;
+            for (const auto &seg : stream) {
+                gro.push(seg);
+            }
+            gro.flush();
+            receiver.segment_received(gro.segments_out().front());
+
+            if (receiver.ackno() != isn + 1 + 10 * MSS or receiver.stream_out().buffer_size() != 10 * MSS) {
+                throw runtime_error("the run was not assembled");
+            }
+            if (not receiver.ack_due()) {
+                throw runtime_error("a run of full-sized segments was not acknowledged at once");
+            }
+            for (const auto &seg : stream) {
+                if (receiver.stream_out().read_buffer(MSS).str().data() != seg.payload().str().data()) {
+                    throw runtime_error("the run's payloads were copied");
+                }
+            }
+            TCPInfo info{};
+            receiver.fill_info(info);
+            if (info.segments_in != 11 or info.bytes_received != 10 * MSS) {
+                throw runtime_error("segments in a run were not counted");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
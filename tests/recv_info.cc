@@ -0,0 +1,65 @@
+#include "tcp_info.hh"
+#include "tcp_receiver.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static void expect(const string &field, const uint64_t actual, const uint64_t expected) {
+    if (actual != expected) {
+        throw runtime_error("TCPInfo::" + field + " was " + to_string(actual) + ", expected " + to_string(expected));
+    }
+}
+
+static TCPSegment segment(const WrappingInt32 seqno, const string &data, const bool syn = false) {
+    TCPSegment seg;
+    seg.header().seqno = seqno;
+    seg.header().syn = syn;
+    seg.payload() = string(data);
+    return seg;
+}
+
+int main() {
+    try {
+        const WrappingInt32 isn{7000};
+        TCPReceiver receiver{4000};
+        TCPInfo info{};
+
+        // Segments are counted even when they are dropped, as this one is before the SYN.
+        receiver.segment_received(segment(isn + 1, "abc"));
+        receiver.segment_received(segment(isn, "", true));
+        receiver.segment_received(segment(isn + 1, "abc"));
+        receiver.fill_info(info);
+        expect("segments_in", info.segments_in, 3);
+        expect("bytes_received", info.bytes_received, 6);
+        expect("rcv_wnd", info.rcv_wnd, 3997);
+        expect("out_of_order_bytes", info.out_of_order_bytes, 0);
+        expect("reassembly_holes", info.reassembly_holes, 0);
+
+        receiver.segment_received(segment(isn + 10, "jkl"));
+        receiver.segment_received(segment(isn + 13, "mn"));
+        receiver.segment_received(segment(isn + 20, "tuv"));
+        receiver.fill_info(info);
+        expect("out_of_order_bytes", info.out_of_order_bytes, 8);
+        expect("reassembly_holes", info.reassembly_holes, 2);
+
+        receiver.segment_received(segment(isn + 4, "defghi"));
+        receiver.fill_info(info);
+        expect("segments_in", info.segments_in, 7);
+        expect("bytes_received", info.bytes_received, 20);
+        expect("rcv_wnd", info.rcv_wnd, 4000 - 14);
+        expect("out_of_order_bytes", info.out_of_order_bytes, 3);
+        expect("reassembly_holes", info.reassembly_holes, 1);
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
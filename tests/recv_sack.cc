@@ -0,0 +1,59 @@
+#include "receiver_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            // No SACK blocks unless the SYN permitted them
+            size_t cap = 4000;
+            uint32_t isn = 23452;
+            TCPReceiverTestHarness test{cap};
+            test.execute(SegmentArrives{}.with_syn().with_seqno(isn).with_result(SegmentArrives::Result::OK));
+            test.execute(
+                SegmentArrives{}.with_seqno(isn + 5).with_data("efgh").with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectUnassembledBytes{4});
+            test.execute(ExpectSackBlocks{{}});
+        }
+
+        {
+            // Out-of-order data is reported, most recent block first
+            size_t cap = 4000;
+            uint32_t isn = 23452;
+            TCPReceiverTestHarness test{cap};
+            test.execute(
+                SegmentArrives{}.with_syn().with_sack_permitted().with_seqno(isn).with_result(
+                    SegmentArrives::Result::OK));
+            test.execute(ExpectSackBlocks{{}});
+            test.execute(
+                SegmentArrives{}.with_seqno(isn + 5).with_data("efgh").with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectSackBlocks{{{WrappingInt32{isn + 5}, WrappingInt32{isn + 9}}}});
+            test.execute(
+                SegmentArrives{}.with_seqno(isn + 13).with_data("mnop").with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectSackBlocks{{{WrappingInt32{isn + 13}, WrappingInt32{isn + 17}},
+                                           {WrappingInt32{isn + 5}, WrappingInt32{isn + 9}}}});
+            // adjacent ranges are merged into one block
+            test.execute(
+                SegmentArrives{}.with_seqno(isn + 9).with_data("ijkl").with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectSackBlocks{{{WrappingInt32{isn + 5}, WrappingInt32{isn + 17}}}});
+            test.execute(
+                SegmentArrives{}.with_seqno(isn + 1).with_data("abcd").with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectAckno{WrappingInt32{isn + 17}});
+            test.execute(ExpectSackBlocks{{}});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
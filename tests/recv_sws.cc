@@ -0,0 +1,119 @@
+#include "receiver_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            // The advertised window opens only in steps of at least one MSS
+            TCPConfig cfg;
+            cfg.recv_capacity = 4000;
+            uint32_t isn = rd();
+            TCPReceiverTestHarness test{cfg};
+            test.execute(SegmentArrives{}.with_syn().with_seqno(isn));
+            test.execute(ExpectAdvertisedWindow{4000});
+            test.execute(AckSent{});
+            test.execute(SegmentArrives{}.with_seqno(isn + 1).with_data(string(3000, 'a')));
+            test.execute(AckSent{});
+            test.execute(ExpectAdvertisedWindow{1000});
+
+            test.execute(ReadBytes{100});
+            test.execute(ExpectWindow{1100});
+            test.execute(ExpectAdvertisedWindow{1000});
+            test.execute(ReadBytes{1000});
+            test.execute(ExpectWindow{2100});
+            test.execute(ExpectAdvertisedWindow{1000});
+            test.execute(ExpectWindowAdvertisement{1000});
+            test.execute(ExpectWindowUpdateDue{false});
+            test.execute(ExpectAckDue{false});
+
+            // The reader has now made room for an MSS beyond the advertised edge, doubling the window
+            test.execute(ReadBytes{400});
+            test.execute(ExpectAdvertisedWindow{2500});
+            test.execute(ExpectWindowUpdateDue{true});
+            test.execute(ExpectAckDue{true});
+            test.execute(ExpectWindowAdvertisement{2500});
+            test.execute(AckSent{});
+            test.execute(ExpectWindowUpdateDue{false});
+
+            // Arriving data shrinks the advertised window, and small reads leave its edge where it was
+            test.execute(SegmentArrives{}.with_seqno(isn + 3001).with_data(string(2000, 'b')));
+            test.execute(AckSent{});
+            test.execute(ExpectAdvertisedWindow{500});
+            test.execute(ReadBytes{10});
+            test.execute(ExpectWindow{510});
+            test.execute(ExpectAdvertisedWindow{500});
+        }
+
+        {
+            // The window field sent to the peer moves the advertised edge even if ack_sent() is not called
+            TCPConfig cfg;
+            cfg.recv_capacity = 4000;
+            uint32_t isn = rd();
+            TCPReceiverTestHarness test{cfg};
+            test.execute(SegmentArrives{}.with_syn().with_seqno(isn));
+            test.execute(SegmentArrives{}.with_seqno(isn + 1).with_data(string(3000, 'a')));
+            test.execute(ExpectWindowAdvertisement{1000});
+            test.execute(ReadBytes{1500});
+            test.execute(ExpectWindowUpdateDue{true});
+            test.execute(ExpectWindowAdvertisement{2500});
+            test.execute(ExpectWindowUpdateDue{false});
+
+            test.execute(SegmentArrives{}.with_seqno(isn + 3001).with_data(string(2000, 'b')));
+            test.execute(ExpectWindowAdvertisement{500});
+            test.execute(ReadBytes{10});
+            test.execute(ExpectAdvertisedWindow{500});
+        }
+
+        {
+            // A zero window stays closed until the reader has made room for a full segment
+            TCPConfig cfg;
+            cfg.recv_capacity = 8000;
+            uint32_t isn = rd();
+            TCPReceiverTestHarness test{cfg};
+            test.execute(SegmentArrives{}.with_syn().with_seqno(isn));
+            test.execute(SegmentArrives{}.with_seqno(isn + 1).with_data(string(8000, 'a')));
+            test.execute(AckSent{});
+            test.execute(ExpectAdvertisedWindow{0});
+            test.execute(ReadBytes{1});
+            test.execute(ExpectWindow{1});
+            test.execute(ExpectAdvertisedWindow{0});
+            test.execute(ExpectWindowUpdateDue{false});
+            test.execute(ReadBytes{TCPConfig::MAX_PAYLOAD_SIZE - 2});
+            test.execute(ExpectAdvertisedWindow{0});
+            test.execute(ReadBytes{1});
+            test.execute(ExpectAdvertisedWindow{TCPConfig::MAX_PAYLOAD_SIZE});
+            test.execute(ExpectWindowUpdateDue{true});
+        }
+
+        {
+            // With a small buffer the step is half of it
+            TCPConfig cfg;
+            cfg.recv_capacity = 1000;
+            uint32_t isn = rd();
+            TCPReceiverTestHarness test{cfg};
+            test.execute(SegmentArrives{}.with_syn().with_seqno(isn));
+            test.execute(SegmentArrives{}.with_seqno(isn + 1).with_data(string(1000, 'a')));
+            test.execute(AckSent{});
+            test.execute(ReadBytes{499});
+            test.execute(ExpectAdvertisedWindow{0});
+            test.execute(ReadBytes{1});
+            test.execute(ExpectAdvertisedWindow{500});
+            test.execute(ExpectWindowUpdateDue{true});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
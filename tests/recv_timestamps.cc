@@ -0,0 +1,93 @@
+#include "receiver_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            // TS.Recent follows in-order segments, and PAWS drops old duplicates
+            TCPConfig cfg;
+            cfg.timestamps = true;
+            cfg.recv_capacity = 4000;
+            uint32_t isn = 7000;
+            TCPReceiverTestHarness test{cfg};
+            test.execute(ExpectTsRecent{nullopt});
+            test.execute(SegmentArrives{}.with_syn().with_timestamps(100, 0).with_seqno(isn).with_result(
+                SegmentArrives::Result::OK));
+            test.execute(ExpectTsRecent{100});
+            test.execute(SegmentArrives{}.with_seqno(isn + 1).with_data("abc").with_timestamps(105, 0));
+            test.execute(ExpectTsRecent{105});
+            test.execute(ExpectTotalAssembledBytes{3});
+
+            // Out-of-order data is kept, but does not move TS.Recent
+            test.execute(SegmentArrives{}.with_seqno(isn + 10).with_data("jkl").with_timestamps(110, 0));
+            test.execute(ExpectTsRecent{105});
+            test.execute(ExpectUnassembledBytes{3});
+
+            // An old TSval marks an old duplicate, even though its data would be new
+            test.execute(SegmentArrives{}.with_seqno(isn + 4).with_data("def").with_timestamps(90, 0));
+            test.execute(ExpectTotalAssembledBytes{3});
+            test.execute(ExpectTsRecent{105});
+
+            test.execute(SegmentArrives{}.with_seqno(isn + 4).with_data("defghi").with_timestamps(105, 0));
+            test.execute(ExpectTotalAssembledBytes{12});
+            test.execute(ExpectBytes{"abcdefghijkl"});
+        }
+
+        {
+            // Timestamps compare modulo 2^32
+            TCPConfig cfg;
+            cfg.timestamps = true;
+            uint32_t isn = 1;
+            TCPReceiverTestHarness test{cfg};
+            test.execute(SegmentArrives{}.with_syn().with_timestamps(0xffff'fff0, 0).with_seqno(isn));
+            test.execute(SegmentArrives{}.with_seqno(isn + 1).with_data("a").with_timestamps(5, 0));
+            test.execute(ExpectTsRecent{5});
+            test.execute(ExpectTotalAssembledBytes{1});
+            test.execute(SegmentArrives{}.with_seqno(isn + 2).with_data("b").with_timestamps(0xffff'fff8, 0));
+            test.execute(ExpectTotalAssembledBytes{1});
+        }
+
+        {
+            // Without the peer's timestamps there is no TS.Recent and no PAWS
+            TCPConfig cfg;
+            cfg.timestamps = true;
+            uint32_t isn = 1;
+            TCPReceiverTestHarness test{cfg};
+            test.execute(SegmentArrives{}.with_syn().with_seqno(isn));
+            test.execute(SegmentArrives{}.with_seqno(isn + 1).with_data("a").with_timestamps(500, 0));
+            test.execute(SegmentArrives{}.with_seqno(isn + 2).with_data("b").with_timestamps(100, 0));
+            test.execute(ExpectTsRecent{nullopt});
+            test.execute(ExpectTotalAssembledBytes{2});
+        }
+
+        {
+            // SACK blocks leave room for the timestamps option
+            TCPConfig cfg;
+            cfg.timestamps = true;
+            uint32_t isn = 1;
+            TCPReceiverTestHarness test{cfg};
+            test.execute(SegmentArrives{}.with_syn().with_sack_permitted().with_timestamps(1, 0).with_seqno(isn));
+            for (uint32_t i = 1; i <= 4; i++) {
+                test.execute(SegmentArrives{}.with_seqno(isn + 1 + 10 * i).with_data("x").with_timestamps(1, 0));
+            }
+            test.execute(ExpectSackBlocks{{{WrappingInt32{isn + 41}, WrappingInt32{isn + 42}},
+                                           {WrappingInt32{isn + 11}, WrappingInt32{isn + 12}},
+                                           {WrappingInt32{isn + 21}, WrappingInt32{isn + 22}}}});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
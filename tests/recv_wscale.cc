@@ -0,0 +1,87 @@
+#include "receiver_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            // A half-gigabyte receive buffer is advertised with a shift of 13
+            TCPConfig cfg;
+            cfg.window_scale = true;
+            cfg.recv_capacity = 500'000'000;
+            uint32_t isn = 3452;
+            TCPReceiverTestHarness test{cfg};
+            test.execute(ExpectWindow{500'000'000});
+            test.execute(SegmentArrives{}.with_syn().with_window_scale(7).with_seqno(isn).with_result(
+                SegmentArrives::Result::OK));
+            test.execute(ExpectWindowAdvertisement{500'000'000 >> 13});
+            test.execute(
+                SegmentArrives{}.with_seqno(isn + 1).with_data(string(20000, 'x')).with_result(
+                    SegmentArrives::Result::OK));
+            test.execute(ExpectWindow{500'000'000 - 20000});
+            test.execute(ExpectWindowAdvertisement{(500'000'000 - 20000) >> 13});
+        }
+
+        {
+            // Beyond 2^30 bytes the advertisement saturates
+            TCPConfig cfg;
+            cfg.window_scale = true;
+            cfg.recv_capacity = size_t{1} << 32;
+            uint32_t isn = 99;
+            TCPReceiverTestHarness test{cfg};
+            test.execute(SegmentArrives{}.with_syn().with_window_scale(0).with_seqno(isn).with_result(
+                SegmentArrives::Result::OK));
+            test.execute(ExpectWindow{size_t{1} << 32});
+            test.execute(ExpectWindowAdvertisement{UINT16_MAX});
+        }
+
+        {
+            // Without the peer's option the window is not scaled, and is clamped to 16 bits
+            TCPConfig cfg;
+            cfg.window_scale = true;
+            cfg.recv_capacity = 500'000'000;
+            uint32_t isn = 1000;
+            TCPReceiverTestHarness test{cfg};
+            test.execute(SegmentArrives{}.with_syn().with_seqno(isn).with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectWindowAdvertisement{UINT16_MAX});
+            test.execute(ExpectWindow{500'000'000});
+        }
+
+        {
+            // Without our offer the window is not scaled either
+            TCPConfig cfg;
+            cfg.window_scale = true;
+            cfg.recv_capacity = 100000;
+            cfg.window_scale = false;
+            uint32_t isn = 1000;
+            TCPReceiverTestHarness test{cfg};
+            test.execute(SegmentArrives{}.with_syn().with_window_scale(5).with_seqno(isn).with_result(
+                SegmentArrives::Result::OK));
+            test.execute(ExpectWindowAdvertisement{UINT16_MAX});
+        }
+
+        {
+            // A small capacity is advertised exactly
+            size_t cap = 4000;
+            uint32_t isn = 1000;
+            TCPReceiverTestHarness test{cap};
+            test.execute(SegmentArrives{}.with_syn().with_window_scale(5).with_seqno(isn).with_result(
+                SegmentArrives::Result::OK));
+            test.execute(ExpectWindowAdvertisement{4000});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,141 @@
+#include "tcp_receiver.hh"
+#include "util.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static size_t allocations = 0;
+
+void *operator new(size_t size) {
+    allocations++;
+    void *ptr = malloc(size ? size : 1);
+    if (not ptr) {
+        throw bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept { free(ptr); }
+
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+
+//! Segments carrying consecutive MSS-sized pieces of `data`, each in storage of its own as a received packet's
+//! payload is, starting at absolute seqno 1
+static vector<TCPSegment> slice(const WrappingInt32 isn, const string &data) {
+    vector<TCPSegment> segments;
+    for (size_t offset = 0; offset < data.size(); offset += TCPConfig::MAX_PAYLOAD_SIZE) {
+        TCPSegment seg;
+        seg.header().seqno = isn + 1 + offset;
+        seg.header().ack = true;
+        seg.payload() = Buffer{data.substr(offset, TCPConfig::MAX_PAYLOAD_SIZE)};
+        segments.push_back(seg);
+    }
+    return segments;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        constexpr size_t rounds = 1000;
+
+        {
+            // The stream holds slices of full-sized in-order payloads; out-of-order data is copied into the
+            // reassembler's own storage, so that it does not keep the packets it arrived in allocated
+            const WrappingInt32 isn(rd());
+            TCPReceiver receiver{TCPConfig{}};
+            TCPSegment syn;
+            syn.header().syn = true;
+            syn.header().seqno = isn;
+            receiver.segment_received(syn);
+
+            const auto segments = slice(isn, string(3 * TCPConfig::MAX_PAYLOAD_SIZE, 'x'));
+            receiver.segment_received(segments[0]);
+            receiver.segment_received(segments[2]);
+            receiver.segment_received(segments[1]);
+            for (size_t i = 0; i < segments.size(); i++) {
+                const TCPSegment &seg = segments[i];
+                const Buffer read = receiver.stream_out().read_buffer(seg.payload().size());
+                const bool shared = read.str().data() == seg.payload().str().data();
+                if (shared != (i != 2)) {
+                    throw runtime_error("segment " + to_string(i) + (shared ? " was shared" : " was copied"));
+                }
+            }
+        }
+
+        {
+            // A small payload is copied, even in order, rather than keep a large receive buffer allocated
+            const WrappingInt32 isn(rd());
+            TCPReceiver receiver{TCPConfig{}};
+            TCPSegment syn;
+            syn.header().syn = true;
+            syn.header().seqno = isn;
+            receiver.segment_received(syn);
+
+            string packet(1 << 20, 'x');
+            packet.resize(1);
+            TCPSegment seg;
+            seg.header().seqno = isn + 1;
+            seg.payload() = Buffer{move(packet)};
+            receiver.segment_received(seg);
+            if (receiver.stream_out().read_buffer(1).str().data() == seg.payload().str().data()) {
+                throw runtime_error("a one-byte payload kept its 1 MB storage alive");
+            }
+        }
+
+        const WrappingInt32 isn(rd());
+        TCPConfig cfg;
+        cfg.recv_capacity = 1 << 20;
+        TCPReceiver receiver{cfg};
+        TCPSegment syn;
+        syn.header().syn = true;
+        syn.header().seqno = isn;
+        receiver.segment_received(syn);
+
+        const auto segments = slice(isn, string(rounds * TCPConfig::MAX_PAYLOAD_SIZE, 'x'));
+        TCPSegment ack;
+        ack.header().ack = true;
+        ack.header().seqno = isn + 1;
+        TCPSegment beyond_window = segments.back();
+        beyond_window.header().seqno = isn + 1 + segments.size() * TCPConfig::MAX_PAYLOAD_SIZE + cfg.recv_capacity;
+
+        // In-order data costs only amortized growth of the stream's queue
+        size_t before = allocations;
+        for (const auto &seg : segments) {
+            receiver.segment_received(seg);
+            receiver.stream_out().pop_output(receiver.stream_out().buffer_size());
+        }
+        size_t used = allocations - before;
+        if (receiver.stream_out().bytes_written() != rounds * TCPConfig::MAX_PAYLOAD_SIZE) {
+            throw runtime_error("in-order segments were not all assembled");
+        }
+        if (used > rounds / 8) {
+            throw runtime_error(to_string(used) + " allocations for " + to_string(rounds) + " in-order segments");
+        }
+
+        // Pure ACKs, duplicates and data beyond the window cost nothing
+        before = allocations;
+        for (size_t i = 0; i < rounds; i++) {
+            receiver.segment_received(ack);
+            receiver.segment_received(segments[i]);
+            receiver.segment_received(beyond_window);
+        }
+        used = allocations - before;
+        if (used != 0) {
+            throw runtime_error(to_string(used) + " allocations for ACKs, duplicates and out-of-window data");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,109 @@
+#include "tcp_config.hh"
+#include "tcp_memory.hh"
+#include "tcp_sender.hh"
+#include "util.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static void check(const bool ok, const string &what) {
+    if (not ok) {
+        throw runtime_error(what);
+    }
+}
+
+//! Sends our SYN and takes the peer's SYN-ACK, which offers `window` bytes and agrees to ECN if `ecn`.
+static void handshake(TCPSender &sender, const WrappingInt32 isn, const uint16_t window, const bool ecn) {
+    sender.fill_window();
+    sender.segments_out().pop();
+    TCPHeader header;
+    header.syn = true;
+    header.ack = true;
+    header.ackno = isn + 1;
+    header.win = window;
+    header.ece = ecn;
+    sender.ack_received(header);
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        TCPConfig cfg;
+        cfg.send_capacity = 4000;
+        cfg.max_send_capacity = 100000;
+        cfg.window_scale = false;
+
+        {
+            // Without autotuning the writer is held to the configured capacity
+            const WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            TCPSender sender{cfg};
+            handshake(sender, isn, 60000, false);
+            check(sender.stream_in().capacity() == 4000, "the capacity changed without autotuning");
+            check(sender.stream_in().write(string(10000, 'x')) == 4000, "the writer was not held to the capacity");
+        }
+
+        cfg.autotune = true;
+
+        {
+            // The buffer grows to twice the peer's window, up to the maximum, and does not shrink with it
+            const WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            TCPSender sender{cfg};
+            check(sender.stream_in().capacity() == 4000, "the capacity grew before the peer's window was known");
+            handshake(sender, isn, 20000, false);
+            check(sender.stream_in().capacity() == 40000, "the capacity did not follow the peer's window");
+            check(sender.stream_in().write(string(50000, 'x')) == 40000, "the writer was not held to the capacity");
+
+            sender.ack_received(isn + 1, 60000);
+            check(sender.stream_in().capacity() == 100000, "the capacity did not stop at the maximum");
+            sender.ack_received(isn + 1, 1000);
+            check(sender.stream_in().capacity() == 100000, "the capacity shrank with the window");
+
+            TCPInfo info{};
+            sender.fill_info(info);
+            check(info.snd_capacity == 100000, "fill_info() does not report the capacity");
+        }
+
+        {
+            // With ECN the congestion window, when smaller, sets the size
+            const WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.ecn = true;
+            TCPSender sender{cfg};
+            handshake(sender, isn, 60000, true);
+            const uint64_t cwnd = sender.congestion_window().value();
+            check(cwnd < 30000, "the initial congestion window is not the smaller");
+            check(sender.stream_in().capacity() == 2 * cwnd, "the capacity did not follow the congestion window");
+            cfg.ecn = false;
+        }
+
+        {
+            // Growth comes out of the memory budget, and goes back to it with the sender
+            cfg.memory_budget = make_shared<TCPMemoryBudget>(10000);
+            {
+                const WrappingInt32 isn(rd());
+                cfg.fixed_isn = isn;
+                TCPSender sender{cfg};
+                handshake(sender, isn, 60000, false);
+                check(sender.stream_in().capacity() == 14000, "the capacity grew beyond the budget");
+                check(cfg.memory_budget->used() == 10000, "the budget lost track of its share");
+            }
+            check(cfg.memory_budget->used() == 0, "the share was not returned");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,154 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Without Nagle or cork every write is sent at once", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(WriteBytes{"a"});
+            test.execute(ExpectSegment{}.with_data("a").with_psh(false));
+            test.execute(WriteBytes{"b"});
+            test.execute(ExpectSegment{}.with_data("b").with_psh(false));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.nagle = true;
+
+            TCPSenderTestHarness test{"Nagle holds small writes while data is unacknowledged", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(5000));
+            test.execute(WriteBytes{"a"});
+            test.execute(ExpectSegment{}.with_data("a").with_seqno(isn + 1));
+            test.execute(WriteBytes{"b"});
+            test.execute(WriteBytes{"c"});
+            test.execute(WriteBytes{"d"});
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{1});
+            test.execute(AckReceived{WrappingInt32{isn + 2}}.with_win(5000));
+            test.execute(ExpectSegment{}.with_data("bcd").with_seqno(isn + 2));
+            test.execute(ExpectNoSegment{});
+
+            // A full segment is never held.
+            test.execute(WriteBytes{string(TCPConfig::MAX_PAYLOAD_SIZE + 10, 'x')});
+            test.execute(ExpectSegment{}.with_payload_size(TCPConfig::MAX_PAYLOAD_SIZE).with_seqno(isn + 5));
+            test.execute(ExpectNoSegment{});
+
+            // Flush sends the tail and marks it with PSH.
+            test.execute(Flush{});
+            test.execute(ExpectSegment{}.with_payload_size(10).with_psh(true));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.nagle = true;
+
+            TCPSenderTestHarness test{"Nagle sends held data with the FIN", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(WriteBytes{"a"});
+            test.execute(ExpectSegment{}.with_data("a"));
+            test.execute(WriteBytes{"b"});
+            test.execute(ExpectNoSegment{});
+            test.execute(Close{});
+            test.execute(ExpectSegment{}.with_data("b").with_fin(true));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.nagle = true;
+
+            TCPSenderTestHarness test{"Nagle does not hold a segment limited by the window", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(3));
+            test.execute(WriteBytes{"abcde"});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            test.execute(AckReceived{WrappingInt32{isn + 2}}.with_win(3));
+            test.execute(ExpectSegment{}.with_data("d"));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.cork = true;
+
+            TCPSenderTestHarness test{"Cork accumulates until a full segment or uncork", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(5000));
+            test.execute(WriteBytes{"hello "});
+            test.execute(ExpectNoSegment{});
+            test.execute(WriteBytes{"world"});
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{0});
+
+            // Unlike Nagle, an ACK does not release a corked partial segment.
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(5000));
+            test.execute(ExpectNoSegment{});
+
+            test.execute(WriteBytes{string(TCPConfig::MAX_PAYLOAD_SIZE, 'x')});
+            test.execute(ExpectSegment{}
+                             .with_data("hello world" + string(TCPConfig::MAX_PAYLOAD_SIZE - 11, 'x'))
+                             .with_psh(false));
+            test.execute(ExpectNoSegment{});
+            test.execute(SetCork{false});
+            test.execute(ExpectSegment{}.with_data(string(11, 'x')).with_psh(true));
+            test.execute(WriteBytes{"y"});
+            test.execute(ExpectSegment{}.with_data("y").with_psh(false));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Flush while corked sends the pending data and stays corked", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(5000));
+            test.execute(SetCork{true});
+            test.execute(WriteBytes{"GET / HTTP/1.1\r\n"});
+            test.execute(WriteBytes{"Host: x\r\n\r\n"});
+            test.execute(ExpectNoSegment{});
+            test.execute(Flush{});
+            test.execute(ExpectSegment{}.with_data("GET / HTTP/1.1\r\nHost: x\r\n\r\n").with_psh(true));
+            test.execute(WriteBytes{"more"});
+            test.execute(ExpectNoSegment{});
+            test.execute(Flush{});
+            test.execute(ExpectSegment{}.with_data("more").with_psh(true));
+
+            // A flush with nothing new to send is a no-op.
+            test.execute(Flush{});
+            test.execute(ExpectNoSegment{});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
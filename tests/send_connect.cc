@@ -26,6 +26,25 @@ int main() {
             test.execute(ExpectBytesInFlight{1});
         }
 
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            // SACK, window scaling, timestamps, ECN and Fast Open are all opt-in
+            TCPSenderTestHarness test{"Default SYN carries only the MSS option", cfg};
+            test.execute(ExpectSegment{}
+                             .with_syn(true)
+                             .with_mss(TCPConfig::MAX_PAYLOAD_SIZE)
+                             .with_sack_permitted(false)
+                             .with_window_scale(nullopt)
+                             .with_tsval(nullopt)
+                             .with_fastopen_cookie(nullopt)
+                             .with_ece(false)
+                             .with_cwr(false)
+                             .with_seqno(isn));
+        }
+
         {
             TCPConfig cfg;
             WrappingInt32 isn(rd());
@@ -0,0 +1,175 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Without ECN nothing is marked or limited", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_ece(false).with_cwr(false));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_syn().with_ece());
+            test.execute(ExpectCongestionWindow{nullopt});
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc").with_ect(false).with_cwr(false));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.ecn = true;
+
+            TCPSenderTestHarness test{"A peer that does not agree leaves ECN off", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_ece(true).with_cwr(true));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_syn());
+            test.execute(ExpectCongestionWindow{nullopt});
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc").with_ect(false));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.ecn = true;
+
+            TCPSenderTestHarness test{"A SYN-ACK with both ECE and CWR does not agree to ECN", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_ece(true).with_cwr(true));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_syn().with_ece().with_cwr());
+            test.execute(ExpectCongestionWindow{nullopt});
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc").with_ect(false));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.ecn = true;
+            cfg.fastopen_cookie = "abcdefgh";
+
+            TCPSenderTestHarness test{"A SYN with Fast Open data is still an ECN-setup SYN", cfg, "hello"};
+            test.execute(ExpectSegment{}.with_syn(true).with_data("hello").with_ece(true).with_cwr(true));
+            test.execute(AckReceived{WrappingInt32{isn + 6}}.with_win(1000).with_syn().with_ece());
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc").with_ect(true).with_cwr(false));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.ecn = true;
+
+            TCPSenderTestHarness test{"Classic ECN halves the window once per window of data", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_ece(true).with_cwr(true));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000).with_syn().with_ece());
+            test.execute(ExpectCongestionWindow{10 * 1452});
+
+            // The initial window limits the first flight.
+            test.execute(WriteBytes{string(20000, 'x')});
+            for (unsigned int i = 0; i < 10; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1452).with_ect(true).with_cwr(false));
+            }
+            test.execute(ExpectNoSegment{});
+
+            // A mark halves the flight that is left.
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 2904}}.with_win(60000).with_ece());
+            test.execute(ExpectCongestionWindow{5808});
+            test.execute(ExpectNoSegment{});
+
+            // More marks on data sent before the reduction do not reduce it again.
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 4356}}.with_win(60000).with_ece());
+            test.execute(ExpectCongestionWindow{5808 + 363});
+            test.execute(ExpectNoSegment{});
+
+            // The next new segment reports the reduction with CWR.
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 14520}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{5808 + 363 + 341});
+            test.execute(ExpectSegment{}.with_payload_size(1452).with_ect(true).with_cwr(true));
+            test.execute(ExpectSegment{}.with_payload_size(1452).with_cwr(false));
+            test.execute(ExpectSegment{}.with_payload_size(1452).with_cwr(false));
+            test.execute(ExpectSegment{}.with_payload_size(1124).with_cwr(false));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.ecn = true;
+
+            TCPSenderTestHarness test{"Retransmissions are not ECN-capable", cfg};
+            test.execute(ExpectSegment{}.with_syn(true));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_syn().with_ece());
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc").with_ect(true));
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectSegment{}.with_data("abc").with_ect(false));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.ecn = true;
+            cfg.dctcp = true;
+
+            TCPSenderTestHarness test{"DCTCP cuts the window by the fraction of bytes marked", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_ece(true).with_cwr(true));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000).with_syn().with_ece());
+            test.execute(ExpectDctcpAlpha{1024});
+            test.execute(WriteBytes{string(30000, 'x')});
+            for (unsigned int i = 0; i < 10; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1452).with_ect(true));
+            }
+
+            // alpha starts at 1, so the first mark halves the window.
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 7260}}.with_win(60000).with_ece());
+            test.execute(ExpectDctcpAlpha{1024});
+            test.execute(ExpectCongestionWindow{7260});
+            test.execute(ExpectNoSegment{});
+
+            // 7260 + 1452 * 1452 / 7260
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 14520}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{7550});
+            test.execute(ExpectSegment{}.with_payload_size(1452).with_cwr(true));
+            for (unsigned int i = 0; i < 5; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1452).with_cwr(false));
+            }
+
+            // A window without marks lowers alpha by g = 1/16: 1024 - 64.
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 14520 + 8712}}.with_win(60000));
+            test.execute(ExpectDctcpAlpha{960});
+            test.execute(ExpectCongestionWindow{7829});
+            for (unsigned int i = 0; i < 4; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1452));
+            }
+            test.execute(ExpectSegment{}.with_payload_size(960));
+
+            // A fully marked window raises alpha to 960 - 60 + 64, and the cut is 7829 * 964 / 2048 bytes.
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 23232 + 2904}}.with_win(60000).with_ece());
+            test.execute(ExpectDctcpAlpha{964});
+            test.execute(ExpectCongestionWindow{7829 - 3685});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
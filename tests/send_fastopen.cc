@@ -0,0 +1,117 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Without Fast Open the SYN carries no data", cfg, "hello"};
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(0).with_fastopen_cookie(nullopt));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(ExpectSegment{}.with_data("hello").with_seqno(isn + 1));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.fastopen_cookie = "";
+
+            TCPSenderTestHarness test{"A SYN without a cookie asks for one", cfg, "hello"};
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(0).with_fastopen_cookie(""));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_syn_fastopen_cookie("abcdefgh"));
+            test.execute(ExpectIssuedFastOpenCookie{"abcdefgh"});
+            test.execute(ExpectSegment{}.with_data("hello").with_seqno(isn + 1).with_fastopen_cookie(nullopt));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.fastopen_cookie = "abcdefgh";
+
+            TCPSenderTestHarness test{"With a cookie, data rides on the SYN", cfg, "hello"};
+            test.execute(
+                ExpectSegment{}.with_syn(true).with_seqno(isn).with_data("hello").with_fastopen_cookie("abcdefgh"));
+            test.execute(ExpectBytesInFlight{6});
+            test.execute(AckReceived{WrappingInt32{isn + 6}}.with_win(1000).with_syn());
+            test.execute(ExpectBytesInFlight{0});
+            test.execute(ExpectState{TCPSenderStateSummary::SYN_ACKED});
+            test.execute(WriteBytes{"world"});
+            test.execute(ExpectSegment{}.with_data("world").with_seqno(isn + 6));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.fastopen_cookie = "abcdefgh";
+
+            TCPSenderTestHarness test{"Data on the SYN that the server ignored is sent again at once", cfg, "hello"};
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn).with_data("hello"));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_syn_fastopen_cookie("ijklmnop"));
+            test.execute(ExpectIssuedFastOpenCookie{"ijklmnop"});
+            test.execute(ExpectSegment{}
+                             .with_syn(false)
+                             .with_seqno(isn + 1)
+                             .with_data("hello")
+                             .with_mss(nullopt)
+                             .with_fastopen_cookie(nullopt));
+            test.execute(ExpectBytesInFlight{5});
+            test.execute(AckReceived{WrappingInt32{isn + 6}}.with_win(1000));
+            test.execute(ExpectBytesInFlight{0});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.fastopen_cookie = "abcdefgh";
+
+            TCPSenderTestHarness test{"The SYN carries at most one MSS", cfg, string(2000, 'x')};
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(TCPConfig::MAX_PAYLOAD_SIZE));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 1452}}.with_win(1000).with_syn());
+            test.execute(ExpectSegment{}.with_payload_size(548).with_seqno(isn + 1 + 1452));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.fastopen_cookie = "abcdefgh";
+
+            TCPSenderTestHarness test{"Ignored data on the SYN is resent in segments of the peer's MSS", cfg,
+                                      string(TCPConfig::MAX_PAYLOAD_SIZE, 'x')};
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(TCPConfig::MAX_PAYLOAD_SIZE));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(5000).with_syn_mss(536));
+            test.execute(ExpectSegment{}.with_syn(false).with_payload_size(536).with_seqno(isn + 1));
+            test.execute(ExpectSegment{}.with_payload_size(536).with_seqno(isn + 1 + 536));
+            test.execute(ExpectSegment{}.with_payload_size(380).with_seqno(isn + 1 + 1072));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{TCPConfig::MAX_PAYLOAD_SIZE});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 1452}}.with_win(5000));
+            test.execute(ExpectBytesInFlight{0});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
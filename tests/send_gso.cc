@@ -0,0 +1,296 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Open a connection with a window of `window` bytes
+static TCPSender open_sender(const TCPConfig &cfg, const uint16_t window) {
+    TCPSender sender{cfg};
+    sender.fill_window();
+    sender.segments_out().pop();
+    sender.ack_received(cfg.fixed_isn.value() + 1, window);
+    return sender;
+}
+
+// Write `len` bytes in window-sized pieces, acknowledging everything after each, and count the segments sent
+static size_t count_segments(const TCPConfig &cfg, const size_t len) {
+    const uint16_t window = 60000;
+    TCPSender sender = open_sender(cfg, window);
+    size_t segments = 0;
+    for (size_t written = 0; written < len; written += window) {
+        sender.stream_in().write(string(window, 'x'));
+        sender.fill_window();
+        segments += sender.segments_out().size();
+        while (not sender.segments_out().empty()) {
+            sender.segments_out().pop();
+        }
+        sender.ack_received(sender.next_seqno(), window);
+    }
+    return segments;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.gso = true;
+
+            // One super-segment carries the whole write and is split when serialized
+            TCPSender sender = open_sender(cfg, 60000);
+            string data;
+            for (size_t i = 0; i < 50000; i++) {
+                data.push_back(static_cast<char>(rd()));
+            }
+            sender.stream_in().write(data);
+            sender.stream_in().end_input();
+            sender.flush();
+            if (sender.segments_out().size() != 1) {
+                throw runtime_error("expected one super-segment, got " + to_string(sender.segments_out().size()));
+            }
+            const TCPSegment super = sender.segments_out().front();
+            sender.segments_out().pop();
+            if (super.payload().size() != data.size() or super.gso_size() != TCPConfig::MAX_PAYLOAD_SIZE) {
+                throw runtime_error("super-segment has the wrong payload or GSO size");
+            }
+            if (sender.bytes_in_flight() != data.size() + 1) {
+                throw runtime_error("super-segment not counted in flight");
+            }
+
+            const size_t count = super.wire_segment_count();
+            const size_t expected_count = (data.size() + TCPConfig::MAX_PAYLOAD_SIZE - 1) / TCPConfig::MAX_PAYLOAD_SIZE;
+            if (count != expected_count) {
+                throw runtime_error("expected " + to_string(expected_count) + " wire segments, got " +
+                                    to_string(count));
+            }
+
+            // Serialized together, the wire segments share one header whose checksum is updated for each, and the
+            // pseudo-header's TCP length (which is shorter for the last) is added for each
+            const uint32_t pseudo_checksum = rd() & 0xffff;
+            const auto wire_segments = super.serialize_wire_segments(pseudo_checksum);
+            if (wire_segments.size() != count) {
+                throw runtime_error("serialize_wire_segments() made " + to_string(wire_segments.size()) +
+                                    " wire segments");
+            }
+            string reassembled;
+            for (size_t i = 0; i < count; i++) {
+                const string serialized = wire_segments[i].concatenate();
+                const uint32_t wire_pseudo_checksum = pseudo_checksum + serialized.size();
+                if (serialized != super.serialize(wire_pseudo_checksum, i).concatenate()) {
+                    throw runtime_error("wire segment " + to_string(i) + " serialized differently on its own");
+                }
+                TCPSegment wire;
+                if (wire.parse(Buffer{string(serialized)}, wire_pseudo_checksum) != ParseResult::NoError) {
+                    throw runtime_error("wire segment " + to_string(i) + " failed to parse (bad checksum?)");
+                }
+                const bool last = i + 1 == count;
+                if (wire.header().seqno != isn + 1 + i * TCPConfig::MAX_PAYLOAD_SIZE) {
+                    throw runtime_error("wire segment " + to_string(i) + " has the wrong seqno");
+                }
+                const size_t expected_size = last ? data.size() - i * TCPConfig::MAX_PAYLOAD_SIZE
+                                                  : TCPConfig::MAX_PAYLOAD_SIZE;
+                if (wire.payload().size() != expected_size) {
+                    throw runtime_error("wire segment " + to_string(i) + " has the wrong size");
+                }
+                if (wire.header().fin != last or wire.header().psh != last) {
+                    throw runtime_error("FIN and PSH belong on the last wire segment only");
+                }
+                reassembled += wire.payload().copy();
+            }
+            if (reassembled != data) {
+                throw runtime_error("wire segments do not reassemble into the written data");
+            }
+
+            bool threw = false;
+            try {
+                super.serialize(0, count);
+            } catch (const out_of_range &) {
+                threw = true;
+            }
+            if (not threw) {
+                throw runtime_error("serializing a wire segment past the end should throw");
+            }
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.gso = true;
+
+            TCPSenderTestHarness test{"GSO: a small write is still one ordinary segment", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{"hello"});
+            test.execute(ExpectSegment{}.with_data("hello"));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.gso = true;
+
+            // A partial ACK trims the acknowledged wire segments off the super-segment, and a timeout then resends
+            // only the first unacknowledged one, as it would without GSO
+            TCPSender sender = open_sender(cfg, 30000);
+            sender.stream_in().write(string(20000, 'x'));
+            sender.fill_window();
+            sender.segments_out().pop();
+            const size_t acked = 5 * TCPConfig::MAX_PAYLOAD_SIZE + 100;
+            sender.ack_received(isn + 1 + acked, 30000);
+            sender.tick(cfg.rt_timeout);
+            if (sender.segments_out().size() != 1) {
+                throw runtime_error("expected one retransmission");
+            }
+            const TCPSegment &retx = sender.segments_out().front();
+            if (retx.header().seqno != isn + 1 + 5 * TCPConfig::MAX_PAYLOAD_SIZE or
+                retx.payload().size() != TCPConfig::MAX_PAYLOAD_SIZE or retx.gso_size() != 0) {
+                throw runtime_error("retransmission should be the first unacknowledged wire segment alone");
+            }
+            sender.segments_out().pop();
+            sender.ack_received(isn + 1 + 20000, 30000);
+            if (sender.bytes_in_flight() != 0) {
+                throw runtime_error("the super-segment should be fully acknowledged");
+            }
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.gso = true;
+            cfg.rack_tlp = true;
+
+            // A tail loss probe resends the last wire segment of a super-segment, and a timeout the first
+            const size_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+            TCPSender sender{cfg};
+            sender.fill_window();
+            sender.segments_out().pop();
+            sender.tick(10);
+            sender.ack_received(isn + 1, 60000);
+            sender.stream_in().write(string(20 * mss, 'x'));
+            sender.fill_window();
+            if (sender.segments_out().size() != 1 or sender.segments_out().front().wire_segment_count() != 20) {
+                throw runtime_error("expected one super-segment of twenty wire segments");
+            }
+            sender.segments_out().pop();
+
+            const auto expect_one_wire_segment = [&](const string &when, const size_t index) {
+                if (sender.segments_out().size() != 1) {
+                    throw runtime_error(when + ": expected one segment, got " +
+                                        to_string(sender.segments_out().size()));
+                }
+                const TCPSegment &retx = sender.segments_out().front();
+                if (retx.header().seqno != isn + 1 + index * mss or retx.payload().size() != mss or
+                    retx.wire_segment_count() != 1) {
+                    throw runtime_error(when + ": expected wire segment " + to_string(index) + " alone, got " +
+                                        to_string(retx.payload().size()) + " bytes");
+                }
+                sender.segments_out().pop();
+            };
+            // PTO = 2 * SRTT + delayed-ACK allowance for a single segment in flight
+            sender.tick(220);
+            expect_one_wire_segment("tail loss probe", 19);
+            sender.tick(cfg.rt_timeout);
+            expect_one_wire_segment("timeout", 0);
+            sender.tick(2 * cfg.rt_timeout);
+            expect_one_wire_segment("second timeout", 0);
+
+            sender.ack_received(isn + 1 + 20 * mss, 60000);
+            if (sender.bytes_in_flight() != 0) {
+                throw runtime_error("the super-segment should be fully acknowledged");
+            }
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.gso = true;
+            cfg.sack = true;
+
+            // A wire segment lost from the middle of a super-segment is resent alone, by fast retransmit and then
+            // by the retransmission timer, once the peer SACKs the wire segments after it
+            TCPSender sender{cfg};
+            sender.fill_window();
+            sender.segments_out().pop();
+            TCPHeader syn_ack;
+            syn_ack.syn = syn_ack.ack = syn_ack.sack_permitted = true;
+            syn_ack.ackno = isn + 1;
+            syn_ack.win = 60000;
+            sender.ack_received(syn_ack);
+
+            const size_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+            sender.stream_in().write(string(10 * mss, 'x'));
+            sender.fill_window();
+            if (sender.segments_out().size() != 1 or sender.segments_out().front().wire_segment_count() != 10) {
+                throw runtime_error("expected one super-segment of ten wire segments");
+            }
+            sender.segments_out().pop();
+
+            // The first wire segment arrives, the second is lost, and the other eight are SACKed
+            TCPHeader ack;
+            ack.ack = true;
+            ack.ackno = isn + 1 + mss;
+            ack.win = 60000;
+            ack.sack_blocks.push_back({isn + 1 + 2 * mss, isn + 1 + 10 * mss});
+            sender.ack_received(ack);
+
+            const auto expect_lost_segment_alone = [&](const string &when) {
+                if (sender.segments_out().size() != 1) {
+                    throw runtime_error(when + ": expected one retransmission, got " +
+                                        to_string(sender.segments_out().size()));
+                }
+                const TCPSegment &retx = sender.segments_out().front();
+                if (retx.header().seqno != isn + 1 + mss or retx.payload().size() != mss or retx.gso_size() != 0) {
+                    throw runtime_error(when + ": only the lost wire segment should be resent");
+                }
+                sender.segments_out().pop();
+            };
+            if (not sender.in_recovery()) {
+                throw runtime_error("SACKs inside a super-segment should start loss recovery");
+            }
+            expect_lost_segment_alone("fast retransmit");
+            sender.tick(cfg.rt_timeout);
+            expect_lost_segment_alone("timeout");
+
+            ack.ackno = isn + 1 + 10 * mss;
+            ack.sack_blocks.clear();
+            sender.ack_received(ack);
+            if (sender.bytes_in_flight() != 0) {
+                throw runtime_error("the repaired super-segment should be fully acknowledged");
+            }
+        }
+
+        // Bulk transfer: far fewer segments for the sender to build, queue and track
+        {
+            TCPConfig cfg;
+            cfg.fixed_isn = WrappingInt32(rd());
+            const size_t without_gso = count_segments(cfg, 600000);
+            cfg.gso = true;
+            const size_t with_gso = count_segments(cfg, 600000);
+            if (with_gso * 10 > without_gso) {
+                throw runtime_error("GSO sent " + to_string(with_gso) + " segments, versus " +
+                                    to_string(without_gso) + " without it");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
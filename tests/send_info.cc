@@ -0,0 +1,87 @@
+#include "sender_harness.hh"
+#include "tcp_info.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static void expect(const string &field, const uint64_t actual, const uint64_t expected) {
+    if (actual != expected) {
+        throw runtime_error("TCPInfo::" + field + " was " + to_string(actual) + ", expected " + to_string(expected));
+    }
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        TCPConfig cfg;
+        WrappingInt32 isn(rd());
+        cfg.fixed_isn = isn;
+        TCPSender sender{cfg};
+        TCPInfo info{};
+
+        sender.fill_window();
+        sender.fill_info(info);
+        expect("segments_out", info.segments_out, 1);
+        expect("bytes_sent", info.bytes_sent, 0);
+        expect("bytes_in_flight", info.bytes_in_flight, 1);
+        expect("rto_ms", info.rto_ms, cfg.rt_timeout);
+        expect("rtt_valid", info.rtt_valid, false);
+
+        sender.tick(10);
+        sender.ack_received(isn + 1, 10000);
+        sender.stream_in().write(string(3000, 'x'));
+        sender.fill_window();
+        sender.fill_info(info);
+        expect("rtt_valid", info.rtt_valid, true);
+        expect("srtt_ms", info.srtt_ms, 10);
+        expect("rttvar_ms", info.rttvar_ms, 5);
+        expect("segments_out", info.segments_out, 4);
+        expect("bytes_sent", info.bytes_sent, 3000);
+        expect("bytes_acked", info.bytes_acked, 0);
+        expect("bytes_in_flight", info.bytes_in_flight, 3000);
+        expect("snd_wnd", info.snd_wnd, 10000);
+        expect("mss", info.mss, TCPConfig::MAX_PAYLOAD_SIZE);
+
+        // A timeout resends the first segment and backs off the timer.
+        sender.tick(cfg.rt_timeout);
+        sender.fill_info(info);
+        expect("segments_out", info.segments_out, 5);
+        expect("retransmissions", info.retransmissions, 1);
+        expect("bytes_sent", info.bytes_sent, 3000 + TCPConfig::MAX_PAYLOAD_SIZE);
+        expect("bytes_retransmitted", info.bytes_retransmitted, TCPConfig::MAX_PAYLOAD_SIZE);
+        expect("timeouts", info.timeouts, 1);
+        expect("consecutive_timeouts", info.consecutive_timeouts, 1);
+        expect("rto_ms", info.rto_ms, 2 * cfg.rt_timeout);
+
+        sender.ack_received(isn + 1 + TCPConfig::MAX_PAYLOAD_SIZE, 10000);
+        sender.fill_info(info);
+        expect("bytes_acked", info.bytes_acked, TCPConfig::MAX_PAYLOAD_SIZE);
+        expect("bytes_in_flight", info.bytes_in_flight, 3000 - TCPConfig::MAX_PAYLOAD_SIZE);
+        expect("timeouts", info.timeouts, 1);
+        expect("consecutive_timeouts", info.consecutive_timeouts, 0);
+        expect("rto_ms", info.rto_ms, cfg.rt_timeout);
+        expect("snd_wnd", info.snd_wnd, 10000);
+
+        // The FIN is not payload.
+        sender.stream_in().end_input();
+        sender.fill_window();
+        sender.ack_received(isn + 3002, 10000);
+        sender.fill_info(info);
+        expect("segments_out", info.segments_out, 6);
+        expect("bytes_acked", info.bytes_acked, 3000);
+        expect("bytes_in_flight", info.bytes_in_flight, 0);
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,185 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+//! Runs a sender with path MTU discovery over a path that drops every segment with more than `path_limit` bytes of
+//! payload, and returns the MSS it settles on.
+static size_t discover(const WrappingInt32 isn, const size_t path_limit) {
+    TCPConfig cfg;
+    cfg.fixed_isn = isn;
+    cfg.mss = 9000;
+    cfg.plpmtud = true;
+    cfg.send_capacity = 200000;
+
+    TCPSender sender{cfg};
+    sender.fill_window();
+    sender.segments_out().pop();
+
+    TCPHeader syn;
+    syn.syn = true;
+    syn.ack = true;
+    syn.ackno = isn + 1;
+    syn.win = 60000;
+    syn.mss = 9000;
+    sender.ack_received(syn);
+
+    // Sequence ranges that reached the receiver, keyed by their first absolute seqno.
+    map<uint64_t, uint64_t> received{};
+    uint64_t ackno = 1;
+    for (unsigned int round = 0; round < 500; round++) {
+        if (sender.stream_in().buffer_size() < 20000) {
+            sender.stream_in().write(string(40000, 'x'));
+        }
+        sender.fill_window();
+        while (not sender.segments_out().empty()) {
+            const TCPSegment &seg = sender.segments_out().front();
+            if (seg.payload().size() <= path_limit) {
+                const uint64_t start = unwrap(seg.header().seqno, isn, ackno);
+                received[start] = max(received[start], start + seg.length_in_sequence_space());
+            }
+            sender.segments_out().pop();
+        }
+        const uint64_t previous_ackno = ackno;
+        for (auto it = received.begin(); it != received.end() and it->first <= ackno; it = received.erase(it)) {
+            ackno = max(ackno, it->second);
+        }
+
+        // Acknowledge progress; with none, everything in flight was dropped, so let the timer expire.
+        if (ackno > previous_ackno) {
+            TCPHeader ack;
+            ack.ack = true;
+            ack.ackno = wrap(ackno, isn);
+            ack.win = 60000;
+            sender.ack_received(ack);
+        } else {
+            sender.tick(cfg.rt_timeout);
+        }
+    }
+    return sender.mss();
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"SYN offers our MSS", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_mss(TCPConfig::MAX_PAYLOAD_SIZE).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc").with_mss(nullopt));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Segments fit the peer's smaller MSS", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(5000).with_syn_mss(500));
+            test.execute(ExpectMss{500});
+            test.execute(WriteBytes{string(1200, 'x')});
+            test.execute(ExpectSegment{}.with_payload_size(500).with_seqno(isn + 1));
+            test.execute(ExpectSegment{}.with_payload_size(500).with_seqno(isn + 501));
+            test.execute(ExpectSegment{}.with_payload_size(200).with_seqno(isn + 1001));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.mss = 8960;
+
+            TCPSenderTestHarness test{"A jumbo MSS is used when both ends allow it", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_mss(8960).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000).with_syn_mss(9000));
+            test.execute(ExpectMss{8960});
+            test.execute(WriteBytes{string(10000, 'x')});
+            test.execute(ExpectSegment{}.with_payload_size(8960));
+            test.execute(ExpectSegment{}.with_payload_size(1040));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.mss = 9000;
+            cfg.plpmtud = true;
+
+            TCPSenderTestHarness test{"A delivered probe raises the MSS; a lost one is resent in MSS pieces", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_mss(9000).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000).with_syn_mss(9000));
+            test.execute(ExpectMss{TCPConfig::MAX_PAYLOAD_SIZE});
+
+            // The first probe bisects [1452, 9000].
+            test.execute(WriteBytes{string(5226 + 1452, 'x')});
+            test.execute(ExpectSegment{}.with_payload_size(5226).with_seqno(isn + 1));
+            test.execute(ExpectSegment{}.with_payload_size(1452).with_seqno(isn + 5227));
+            test.execute(ExpectNoSegment{});
+
+            // The probe times out: its data goes again in segments of the old size.
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectSegment{}.with_payload_size(1452).with_seqno(isn + 1));
+            test.execute(ExpectMss{TCPConfig::MAX_PAYLOAD_SIZE});
+            test.execute(AckReceived{WrappingInt32{isn + 1453}}.with_win(60000));
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectSegment{}.with_payload_size(1452).with_seqno(isn + 1453));
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 5226 + 1452}}.with_win(60000));
+            test.execute(ExpectNoSegment{});
+
+            // The next probe bisects [1452, 5226), and is delivered.
+            test.execute(WriteBytes{string(3339, 'y')});
+            test.execute(ExpectSegment{}.with_payload_size(3339));
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 5226 + 1452 + 3339}}.with_win(60000));
+            test.execute(ExpectMss{3339});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.plpmtud = true;
+
+            TCPSenderTestHarness test{"Repeated timeouts fall back to the base MSS", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{string(2000, 'x')});
+            test.execute(ExpectSegment{}.with_payload_size(1452));
+            test.execute(ExpectSegment{}.with_payload_size(548));
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectSegment{}.with_payload_size(1452).with_seqno(isn + 1));
+            test.execute(Tick{2 * size_t{cfg.rt_timeout}});
+            test.execute(ExpectMss{536});
+            test.execute(ExpectSegment{}.with_payload_size(536).with_seqno(isn + 1));
+        }
+
+        for (const size_t path_limit : {1500, 4000, 8000}) {
+            const size_t mss = discover(WrappingInt32(rd()), path_limit);
+            if (mss > path_limit or mss + 32 <= path_limit) {
+                throw runtime_error("path MTU discovery settled on " + to_string(mss) + " for a path carrying " +
+                                    to_string(path_limit));
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
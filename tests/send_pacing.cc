@@ -0,0 +1,156 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+struct BurstMetrics {
+    size_t max_burst{};    // most segments released by a single call
+    size_t bytes{};        // payload bytes sent
+    uint64_t elapsed{};    // ms from the write until the last segment left
+};
+
+// Open a connection with the given window and SRTT, write `len` bytes, and tick 1 ms at a time
+// until the sender has nothing left to send, recording how the segments left.
+static BurstMetrics measure(TCPConfig cfg, const uint16_t window, const uint64_t srtt, const size_t len) {
+    TCPSender sender{cfg};
+    const WrappingInt32 isn = cfg.fixed_isn.value();
+    sender.fill_window();
+    sender.segments_out().pop();
+    sender.tick(srtt);
+    sender.ack_received(isn + 1, window);
+
+    BurstMetrics metrics{};
+    auto drain = [&](const uint64_t now) {
+        const size_t burst = sender.segments_out().size();
+        metrics.max_burst = max(metrics.max_burst, burst);
+        while (not sender.segments_out().empty()) {
+            metrics.bytes += sender.segments_out().front().payload().size();
+            sender.segments_out().pop();
+        }
+        if (burst > 0) {
+            metrics.elapsed = now;
+        }
+    };
+
+    sender.stream_in().write(string(len, 'x'));
+    sender.fill_window();
+    drain(0);
+    for (uint64_t now = 1; now <= 10 * srtt and metrics.bytes < len; now++) {
+        sender.tick(1);
+        drain(now);
+    }
+    return metrics;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.pacing = true;
+            cfg.pacing_rate_cap = 100000;  // 100 bytes per ms
+
+            TCPSenderTestHarness test{"Paced segments wait for their departure time", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(ExpectNextDeparture{nullopt});
+            test.execute(WriteBytes{string(100, 'a')});
+            test.execute(ExpectSegment{}.with_data(string(100, 'a')));
+            test.execute(WriteBytes{string(100, 'b')});
+            test.execute(WriteBytes{string(100, 'c')});
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectNextDeparture{1});
+            test.execute(ExpectBytesInFlight{100});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_data(string(100, 'b') + string(100, 'c')).with_seqno(isn + 101));
+            test.execute(ExpectNextDeparture{nullopt});
+            test.execute(WriteBytes{string(100, 'd')});
+            test.execute(ExpectNextDeparture{3});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_data(string(100, 'd')).with_seqno(isn + 301));
+            test.execute(ExpectNextDeparture{nullopt});
+            test.execute(ExpectBytesInFlight{400});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Without pacing the window goes out at once", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(WriteBytes{string(100, 'a')});
+            test.execute(WriteBytes{string(100, 'b')});
+            test.execute(ExpectSegment{}.with_data(string(100, 'a')));
+            test.execute(ExpectSegment{}.with_data(string(100, 'b')));
+            test.execute(ExpectNextDeparture{nullopt});
+        }
+
+        // Burst size and throughput with a configured rate cap
+        {
+            TCPConfig cfg;
+            cfg.fixed_isn = WrappingInt32(rd());
+            const BurstMetrics unpaced = measure(cfg, 60000, 10, 60000);
+            if (unpaced.max_burst < 60000 / TCPConfig::MAX_PAYLOAD_SIZE) {
+                throw runtime_error("unpaced sender should send the whole window at once, but its largest burst was " +
+                                    to_string(unpaced.max_burst) + " segments");
+            }
+
+            cfg.pacing = true;
+            cfg.pacing_rate_cap = 1000000;  // 1000 bytes per ms
+            const BurstMetrics paced = measure(cfg, 60000, 10, 60000);
+            if (paced.max_burst != 1) {
+                throw runtime_error("paced sender released " + to_string(paced.max_burst) + " segments at once");
+            }
+            if (paced.bytes != 60000) {
+                throw runtime_error("paced sender sent " + to_string(paced.bytes) + " of 60000 bytes");
+            }
+            // 60000 bytes at 1000 bytes per ms: the last of 42 segments leaves 41 intervals after the first
+            const uint64_t expected_ms = 41 * TCPConfig::MAX_PAYLOAD_SIZE / 1000;
+            if (paced.elapsed < expected_ms - 1 or paced.elapsed > expected_ms + 1) {
+                throw runtime_error("paced sender took " + to_string(paced.elapsed) + " ms, expected about " +
+                                    to_string(expected_ms) + " ms");
+            }
+        }
+
+        // Without a cap, the rate spreads the window over the smoothed RTT (with 20% headroom)
+        {
+            TCPConfig cfg;
+            cfg.fixed_isn = WrappingInt32(rd());
+            cfg.pacing = true;
+            const uint64_t srtt = 100;
+            const BurstMetrics paced = measure(cfg, 12000, srtt, 12000);
+            if (paced.max_burst != 1) {
+                throw runtime_error("paced sender released " + to_string(paced.max_burst) + " segments at once");
+            }
+            // 12000 bytes per SRTT with 20% headroom; the last segment leaves after every full one has been sent
+            const uint64_t full_bytes = 12000 / TCPConfig::MAX_PAYLOAD_SIZE * TCPConfig::MAX_PAYLOAD_SIZE;
+            const uint64_t expected_ms = full_bytes * srtt * 100 / (12000 * 120);
+            if (paced.elapsed + 2 < expected_ms or paced.elapsed > expected_ms + 2) {
+                throw runtime_error("paced sender took " + to_string(paced.elapsed) + " ms, expected about " +
+                                    to_string(expected_ms) + " ms");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,134 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            cfg.sack = true;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = 1000;
+            cfg.rack_tlp = true;
+
+            TCPSenderTestHarness test{"Lone tail segment is probed before the RTO", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_syn_sack_permitted().with_win(1000));
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            // PTO = 2 * SRTT + delayed-ACK allowance for a single segment in flight
+            test.execute(Tick{219});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_seqno(isn + 1).with_data("abc"));
+            test.execute(ExpectNoSegment{});
+            // only one probe; the RTO restarted from the probe
+            test.execute(Tick{999}.with_max_retx_exceeded(false));
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1}.with_max_retx_exceeded(false));
+            test.execute(ExpectSegment{}.with_seqno(isn + 1).with_data("abc"));
+        }
+
+        {
+            TCPConfig cfg;
+            cfg.sack = true;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = 1000;
+            cfg.rack_tlp = true;
+
+            TCPSenderTestHarness test{"Probe of the last segment exposes the whole lost tail", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_syn_sack_permitted().with_win(1000));
+            test.execute(WriteBytes{"abc"});
+            test.execute(WriteBytes{"def"});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            test.execute(ExpectSegment{}.with_data("def"));
+            test.execute(Tick{19});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_seqno(isn + 4).with_data("def"));
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_sack(isn + 4, isn + 7));
+            test.execute(ExpectSegment{}.with_seqno(isn + 1).with_data("abc"));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 7}}.with_win(1000));
+            test.execute(ExpectBytesInFlight{0});
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            cfg.sack = true;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = 1000;
+            cfg.rack_tlp = true;
+
+            TCPSenderTestHarness test{"Reordering window delays the loss decision", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            test.execute(Tick{40});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_syn_sack_permitted().with_win(1000));
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            test.execute(Tick{5});
+            test.execute(WriteBytes{"def"});
+            test.execute(ExpectSegment{}.with_data("def"));
+            test.execute(Tick{40});
+            // "def" was delivered first, but "abc" may just be reordered: wait RACK.rtt + min_rtt / 4
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_sack(isn + 4, isn + 7));
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{4});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_seqno(isn + 1).with_data("abc"));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            cfg.sack = true;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = 1000;
+            cfg.rack_tlp = true;
+
+            TCPSenderTestHarness test{"Reordered segment that arrives in time is not resent", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            test.execute(Tick{40});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_syn_sack_permitted().with_win(1000));
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            test.execute(Tick{5});
+            test.execute(WriteBytes{"def"});
+            test.execute(ExpectSegment{}.with_data("def"));
+            test.execute(Tick{40});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_sack(isn + 4, isn + 7));
+            test.execute(Tick{2});
+            test.execute(AckReceived{WrappingInt32{isn + 7}}.with_win(1000));
+            test.execute(Tick{200});
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{0});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
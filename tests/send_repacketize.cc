@@ -0,0 +1,136 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            cfg.sack = true;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.repacketize = true;
+
+            TCPSenderTestHarness test{"RTO resends small writes as one segment", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(5000));
+            string all;
+            for (char c = 'a'; c <= 'j'; c++) {
+                test.execute(WriteBytes{string(10, c)});
+                test.execute(ExpectSegment{}.with_data(string(10, c)));
+                all += string(10, c);
+            }
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectSegment{}.with_data(all).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{100});
+            test.execute(Tick{2 * size_t{cfg.rt_timeout}});
+            test.execute(ExpectSegment{}.with_data(all).with_seqno(isn + 1));
+            test.execute(AckReceived{WrappingInt32{isn + 101}}.with_win(5000));
+            test.execute(ExpectBytesInFlight{0});
+        }
+
+        {
+            TCPConfig cfg;
+            cfg.sack = true;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.repacketize = true;
+
+            TCPSenderTestHarness test{"Merged retransmissions stay within one MSS", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(5000));
+            for (char c = 'a'; c <= 'd'; c++) {
+                test.execute(WriteBytes{string(500, c)});
+                test.execute(ExpectSegment{}.with_data(string(500, c)));
+            }
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectSegment{}.with_data(string(500, 'a') + string(500, 'b')).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1001}}.with_win(5000));
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectSegment{}.with_data(string(500, 'c') + string(500, 'd')).with_seqno(isn + 1001));
+        }
+
+        {
+            TCPConfig cfg;
+            cfg.sack = true;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.repacketize = true;
+
+            TCPSenderTestHarness test{"The FIN is merged with the data before it", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(5000));
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            test.execute(WriteBytes{"def"});
+            test.execute(ExpectSegment{}.with_data("def"));
+            test.execute(Close{});
+            test.execute(ExpectSegment{}.with_fin(true).with_payload_size(0));
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectSegment{}.with_data("abcdef").with_fin(true).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 8}}.with_win(5000));
+            test.execute(ExpectState{TCPSenderStateSummary::FIN_ACKED});
+        }
+
+        {
+            TCPConfig cfg;
+            cfg.sack = true;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.repacketize = true;
+
+            TCPSenderTestHarness test{"Fast retransmit merges up to the first SACKed segment", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_syn_sack_permitted().with_win(5000));
+            for (char c = 'a'; c <= 'f'; c++) {
+                test.execute(WriteBytes{string(10, c)});
+                test.execute(ExpectSegment{}.with_data(string(10, c)));
+            }
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(5000).with_sack(isn + 31, isn + 41));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(5000).with_sack(isn + 31, isn + 51));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(5000).with_sack(isn + 31, isn + 61));
+            test.execute(ExpectSegment{}.with_data(string(10, 'a') + string(10, 'b') + string(10, 'c')));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 61}}.with_win(5000));
+            test.execute(ExpectBytesInFlight{0});
+        }
+
+        {
+            TCPConfig cfg;
+            cfg.sack = true;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Without repacketization only the first segment is resent", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(5000));
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            test.execute(WriteBytes{"def"});
+            test.execute(ExpectSegment{}.with_data("def"));
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            test.execute(ExpectNoSegment{});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
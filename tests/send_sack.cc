@@ -0,0 +1,165 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            cfg.sack = true;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"SYN offers SACK-permitted when enabled", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_sack_permitted(true).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_syn_sack_permitted());
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_syn(false).with_sack_permitted(false).with_data("abc"));
+        }
+
+        {
+            TCPConfig cfg;
+            cfg.sack = true;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.sack = false;
+
+            TCPSenderTestHarness test{"SACK disabled: no offer, and SACK blocks are ignored", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_sack_permitted(false).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_syn_sack_permitted().with_win(1000));
+            for (char c = 'a'; c < 'f'; c++) {
+                test.execute(WriteBytes{string(10, c)});
+                test.execute(ExpectSegment{}.with_payload_size(10));
+            }
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_sack(isn + 11, isn + 51));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{50});
+        }
+
+        {
+            TCPConfig cfg;
+            cfg.sack = true;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Peer did not permit SACK: SACK blocks are ignored", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            for (char c = 'a'; c < 'f'; c++) {
+                test.execute(WriteBytes{string(10, c)});
+                test.execute(ExpectSegment{}.with_payload_size(10));
+            }
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_sack(isn + 11, isn + 51));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            cfg.sack = true;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Three duplicate ACKs repair every hole in one round trip", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_syn_sack_permitted().with_win(1000));
+            for (char c = 'a'; c < 'k'; c++) {
+                test.execute(WriteBytes{string(10, c)});
+                test.execute(ExpectSegment{}.with_data(string(10, c)));
+            }
+            test.execute(ExpectBytesInFlight{100});
+
+            // "aaaaaaaaaa" (isn + 1) and "cccccccccc" (isn + 21) are lost
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_sack(isn + 11, isn + 21));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}
+                             .with_win(1000)
+                             .with_sack(isn + 31, isn + 41)
+                             .with_sack(isn + 11, isn + 21));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}
+                             .with_win(1000)
+                             .with_sack(isn + 31, isn + 51)
+                             .with_sack(isn + 11, isn + 21));
+            test.execute(ExpectSegment{}.with_seqno(isn + 1).with_data(string(10, 'a')));
+            test.execute(ExpectSegment{}.with_seqno(isn + 21).with_data(string(10, 'c')));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{100});
+
+            // Partial ACK: the first hole is filled, nothing else needs resending.
+            test.execute(AckReceived{WrappingInt32{isn + 21}}.with_win(1000).with_sack(isn + 31, isn + 51));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 101}}.with_win(1000));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{0});
+        }
+
+        {
+            TCPConfig cfg;
+            cfg.sack = true;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"One ACK SACKing enough data above a hole starts recovery", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_syn_sack_permitted().with_win(1000));
+            for (char c = 'a'; c < 'k'; c++) {
+                test.execute(WriteBytes{string(10, c)});
+                test.execute(ExpectSegment{}.with_data(string(10, c)));
+            }
+
+            // A single ACK SACKing four segments above the first hole triggers recovery at once.
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_sack(isn + 11, isn + 51));
+            test.execute(ExpectSegment{}.with_seqno(isn + 1).with_data(string(10, 'a')));
+            test.execute(ExpectNoSegment{});
+
+            // With no new data to send, the partial ACK's hole below SACKed data is resent (NextSeg rule 3)...
+            test.execute(AckReceived{WrappingInt32{isn + 51}}.with_win(1000).with_sack(isn + 61, isn + 81));
+            test.execute(ExpectSegment{}.with_seqno(isn + 51).with_data(string(10, 'f')));
+            test.execute(ExpectNoSegment{});
+            // ... and only once.
+            test.execute(AckReceived{WrappingInt32{isn + 51}}.with_win(1000).with_sack(isn + 61, isn + 91));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 101}}.with_win(1000));
+            test.execute(ExpectBytesInFlight{0});
+        }
+
+        {
+            TCPConfig cfg;
+            cfg.sack = true;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"SACKed segments are not resent and new data waits for the window", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_syn_sack_permitted().with_win(60));
+            for (char c = 'a'; c < 'g'; c++) {
+                test.execute(WriteBytes{string(10, c)});
+                test.execute(ExpectSegment{}.with_data(string(10, c)));
+            }
+            test.execute(WriteBytes{string(10, 'g')});
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60).with_sack(isn + 11, isn + 61));
+            test.execute(ExpectSegment{}.with_seqno(isn + 1).with_data(string(10, 'a')));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 61}}.with_win(60));
+            test.execute(ExpectSegment{}.with_seqno(isn + 61).with_data(string(10, 'g')));
+            test.execute(ExpectNoSegment{});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,151 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static TCPHeader ack_with_timestamps(const WrappingInt32 ackno, const uint32_t tsecr, const bool syn = false) {
+    TCPHeader header;
+    header.ack = true;
+    header.syn = syn;
+    header.ackno = ackno;
+    header.win = 1000;
+    header.timestamps = TCPTimestamps{12345, tsecr};
+    return header;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            cfg.timestamps = true;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Every segment carries the sender's clock once timestamps are agreed", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_tsval(0).with_seqno(isn));
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_syn().with_timestamps(500, 0).with_win(1000));
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc").with_tsval(10));
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectSegment{}.with_data("abc").with_tsval(10 + cfg.rt_timeout));
+        }
+
+        {
+            TCPConfig cfg;
+            cfg.timestamps = true;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"No timestamps unless the peer's SYN carries them", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_tsval(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_syn().with_win(1000));
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc").with_tsval(nullopt));
+        }
+
+        {
+            TCPConfig cfg;
+            cfg.timestamps = true;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.timestamps = false;
+
+            TCPSenderTestHarness test{"Timestamps can be turned off", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_tsval(nullopt).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_syn().with_timestamps(500, 0).with_win(1000));
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc").with_tsval(nullopt));
+        }
+
+        {
+            // The echo of a retransmission's TSval gives an RTT sample that Karn's algorithm would discard
+            for (const bool timestamps : {true, false}) {
+                TCPConfig cfg;
+                cfg.timestamps = true;
+                WrappingInt32 isn(rd());
+                cfg.fixed_isn = isn;
+                cfg.timestamps = timestamps;
+                TCPSender sender{cfg};
+                sender.fill_window();
+                sender.tick(100);
+                sender.ack_received(ack_with_timestamps(isn + 1, 0, true));
+                if (sender.srtt() != 100) {
+                    throw runtime_error("expected an SRTT of 100 ms from the SYN");
+                }
+
+                sender.stream_in().write("abc");
+                sender.fill_window();
+                sender.tick(cfg.rt_timeout);
+                sender.tick(30);
+                sender.ack_received(ack_with_timestamps(isn + 4, 100 + cfg.rt_timeout));
+                const uint64_t expected = timestamps ? (7 * 100 + 30) / 8 : 100;
+                if (sender.srtt() != expected) {
+                    throw runtime_error("expected an SRTT of " + to_string(expected) + " ms, got " +
+                                        to_string(sender.srtt().value_or(0)));
+                }
+            }
+        }
+
+        {
+            // An echo from the future is not a usable sample
+            TCPConfig cfg;
+            cfg.timestamps = true;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            TCPSender sender{cfg};
+            sender.fill_window();
+            sender.tick(100);
+            sender.ack_received(ack_with_timestamps(isn + 1, 0, true));
+            sender.stream_in().write("abc");
+            sender.fill_window();
+            sender.tick(cfg.rt_timeout);
+            sender.ack_received(ack_with_timestamps(isn + 4, 5000));
+            if (sender.srtt() != 100) {
+                throw runtime_error("a bogus TSecr changed the SRTT");
+            }
+        }
+
+        {
+            // The option survives serialization alongside three SACK blocks, but not four
+            TCPHeader header;
+            header.ack = true;
+            header.timestamps = TCPTimestamps{0xdeadbeef, 42};
+            for (uint32_t i = 0; i < TCPHeader::MAX_SACK_BLOCKS_WITH_TIMESTAMPS; i++) {
+                header.sack_blocks.push_back({WrappingInt32{100 * i}, WrappingInt32{100 * i + 50}});
+            }
+            TCPHeader parsed;
+            NetParser p{header.serialize()};
+            if (parsed.parse(p) != ParseResult::NoError or not(parsed.timestamps == header.timestamps) or
+                parsed.sack_blocks != header.sack_blocks) {
+                throw runtime_error("timestamps option did not round-trip:\n" + parsed.to_string());
+            }
+
+            header.sack_blocks.push_back({WrappingInt32{1000}, WrappingInt32{1050}});
+            bool threw = false;
+            try {
+                header.serialize();
+            } catch (const runtime_error &) {
+                threw = true;
+            }
+            if (not threw) {
+                throw runtime_error("options longer than 40 bytes were serialized");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,150 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            cfg.window_scale = true;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"SYN offers window scaling sized for the receive capacity", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_window_scale(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_syn_window_scale(7));
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc").with_window_scale(nullopt));
+        }
+
+        {
+            TCPConfig cfg;
+            cfg.window_scale = true;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.recv_capacity = 500'000'000;
+
+            TCPSenderTestHarness test{"A large receive capacity needs a large shift", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_window_scale(13).with_seqno(isn));
+        }
+
+        {
+            TCPConfig cfg;
+            cfg.window_scale = true;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.recv_capacity = size_t{1} << 40;
+
+            TCPSenderTestHarness test{"The shift is capped at 14", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_window_scale(14).with_seqno(isn));
+        }
+
+        {
+            TCPConfig cfg;
+            cfg.window_scale = true;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.send_capacity = 200000;
+
+            TCPSenderTestHarness test{"Scaled windows are interpreted once both SYNs carry the option", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            // The window on the SYN itself is not scaled.
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_syn_window_scale(7));
+            test.execute(WriteBytes{string(2000, 'x')});
+            test.execute(ExpectBytesInFlight{1000});
+            // 1000 << 7 = 128000 bytes
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(WriteBytes{string(150000, 'y')});
+            test.execute(ExpectBytesInFlight{128000});
+        }
+
+        {
+            TCPConfig cfg;
+            cfg.window_scale = true;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.send_capacity = 200000;
+
+            TCPSenderTestHarness test{"Shifts above 14 are treated as 14", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1).with_syn_window_scale(20));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(5));
+            test.execute(WriteBytes{string(100000, 'x')});
+            test.execute(ExpectBytesInFlight{5 << 14});
+        }
+
+        {
+            TCPConfig cfg;
+            cfg.window_scale = true;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.window_scale = false;
+
+            TCPSenderTestHarness test{"Without our offer the peer's shift is ignored", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_window_scale(nullopt).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_syn_window_scale(7));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(WriteBytes{string(2000, 'x')});
+            test.execute(ExpectBytesInFlight{1000});
+        }
+
+        {
+            TCPConfig cfg;
+            cfg.window_scale = true;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Without the peer's offer windows are not scaled", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_window_scale(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_syn_sack_permitted());
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(WriteBytes{string(2000, 'x')});
+            test.execute(ExpectBytesInFlight{1000});
+        }
+
+        {
+            // Passive open: our SYN only carries the option if the peer's did
+            TCPConfig cfg;
+            cfg.window_scale = true;
+            cfg.fixed_isn = WrappingInt32(rd());
+            TCPSender sender{cfg};
+            TCPHeader peer_syn;
+            peer_syn.syn = true;
+            sender.ack_received(peer_syn);
+            sender.fill_window();
+            if (sender.segments_out().front().header().window_scale.has_value()) {
+                throw runtime_error("SYN-ACK offered window scaling that the peer did not");
+            }
+        }
+
+        {
+            // The option survives serialization
+            TCPHeader header;
+            header.syn = true;
+            header.sack_permitted = true;
+            header.window_scale = 9;
+            TCPHeader parsed;
+            NetParser p{header.serialize()};
+            if (parsed.parse(p) != ParseResult::NoError or parsed.window_scale != header.window_scale or
+                not parsed.sack_permitted or parsed.doff != 7) {
+                throw runtime_error("window scale option did not round-trip:\n" + parsed.to_string());
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
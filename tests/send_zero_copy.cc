@@ -0,0 +1,127 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static size_t allocations = 0;
+
+void *operator new(size_t size) {
+    allocations++;
+    void *ptr = malloc(size ? size : 1);
+    if (not ptr) {
+        throw bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept { free(ptr); }
+
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        constexpr uint16_t window = 60000;
+        constexpr size_t write_size = 60000;
+        constexpr size_t rounds = 20;
+
+        TCPConfig cfg;
+        WrappingInt32 isn(rd());
+        cfg.fixed_isn = isn;
+
+        TCPSender sender{cfg};
+        sender.fill_window();
+        sender.segments_out().pop();
+        sender.ack_received(isn + 1, window);
+
+        // Payload slices share the written storage, with each other and with their retransmissions
+        {
+            sender.stream_in().write(string(3 * TCPConfig::MAX_PAYLOAD_SIZE, 'x'));
+            sender.fill_window();
+            vector<TCPSegment> sent;
+            while (not sender.segments_out().empty()) {
+                sent.push_back(sender.segments_out().front());
+                sender.segments_out().pop();
+            }
+            if (sent.size() != 3) {
+                throw runtime_error("expected 3 segments, got " + to_string(sent.size()));
+            }
+            for (size_t i = 1; i < sent.size(); i++) {
+                if (sent[i].payload().str().data() !=
+                    sent[i - 1].payload().str().data() + TCPConfig::MAX_PAYLOAD_SIZE) {
+                    throw runtime_error("segment payloads are not slices of the written data");
+                }
+            }
+            sender.tick(cfg.rt_timeout);
+            if (sender.segments_out().size() != 1 or
+                sender.segments_out().front().payload().str().data() != sent[0].payload().str().data()) {
+                throw runtime_error("retransmission does not share the original payload");
+            }
+            sender.segments_out().pop();
+            sender.ack_received(sender.next_seqno(), window);
+        }
+
+        // Small writes are copied onto the last chunk rather than each taking a chunk of its own, but never onto
+        // storage that a reader's slice shares
+        {
+            ByteStream stream{4096};
+            string expected;
+            const size_t before = allocations;
+            for (size_t i = 0; i < 1000; i++) {
+                expected.push_back(static_cast<char>('a' + i % 26));
+                stream.write(expected.substr(i));
+            }
+            if (allocations - before > 20) {
+                throw runtime_error("1000 one-byte writes made " + to_string(allocations - before) + " allocations");
+            }
+            const Buffer head = stream.read_buffer(10);
+            const char *const head_data = head.str().data();
+            stream.write("xyz");
+            expected += "xyz";
+            if (head.str().data() != head_data or head.str() != expected.substr(0, 10) or
+                stream.read(stream.buffer_size()) != expected.substr(10)) {
+                throw runtime_error("merged small writes read back wrong");
+            }
+        }
+
+        // Allocations per MSS sent, with the application's data prepared beforehand
+        vector<string> data(rounds, string(write_size, 'x'));
+        size_t segments = 0;
+        const size_t before = allocations;
+        for (auto &chunk : data) {
+            sender.stream_in().write(move(chunk));
+            sender.fill_window();
+            segments += sender.segments_out().size();
+            while (not sender.segments_out().empty()) {
+                sender.segments_out().pop();
+            }
+            sender.ack_received(sender.next_seqno(), window);
+        }
+        const size_t used = allocations - before;
+
+        const size_t expected_segments =
+            rounds * ((write_size + TCPConfig::MAX_PAYLOAD_SIZE - 1) / TCPConfig::MAX_PAYLOAD_SIZE);
+        if (segments != expected_segments) {
+            throw runtime_error("expected " + to_string(expected_segments) + " segments, got " + to_string(segments));
+        }
+        // One allocation per write (the shared storage) plus amortized queue growth; nothing per payload byte
+        if (used > segments / 2) {
+            throw runtime_error(to_string(used) + " allocations for " + to_string(segments) + " segments");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -15,6 +15,7 @@
 #include <optional>
 #include <sstream>
 #include <string>
+#include <vector>
 
 const unsigned int DEFAULT_TEST_WINDOW = 137;
 
@@ -99,6 +100,87 @@ struct ExpectBytesInFlight : public SenderExpectation {
     }
 };
 
+struct ExpectMss : public SenderExpectation {
+    size_t _mss;
+
+    ExpectMss(size_t mss) : _mss(mss) {}
+    std::string description() const { return "MSS of " + std::to_string(_mss); }
+
+    void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
+        if (sender.mss() != _mss) {
+            std::ostringstream ss;
+            ss << "The TCPSender's MSS was " << sender.mss() << ", but it was expected to be " << _mss;
+            throw SenderExpectationViolation(ss.str());
+        }
+    }
+};
+
+struct ExpectCongestionWindow : public SenderExpectation {
+    std::optional<uint64_t> _cwnd;
+
+    ExpectCongestionWindow(std::optional<uint64_t> cwnd) : _cwnd(cwnd) {}
+    std::string description() const {
+        return "congestion window " + (_cwnd.has_value() ? std::to_string(_cwnd.value()) : "none");
+    }
+
+    void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
+        if (sender.congestion_window() != _cwnd) {
+            std::ostringstream ss;
+            ss << "The TCPSender's congestion window was "
+               << (sender.congestion_window().has_value() ? std::to_string(sender.congestion_window().value()) : "none")
+               << ", but it was expected to be " << description();
+            throw SenderExpectationViolation(ss.str());
+        }
+    }
+};
+
+struct ExpectDctcpAlpha : public SenderExpectation {
+    uint64_t _alpha;
+
+    ExpectDctcpAlpha(uint64_t alpha) : _alpha(alpha) {}
+    std::string description() const { return "DCTCP alpha of " + std::to_string(_alpha) + "/1024"; }
+
+    void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
+        if (sender.dctcp_alpha() != _alpha) {
+            throw SenderExpectationViolation("The TCPSender's DCTCP alpha was " + std::to_string(sender.dctcp_alpha()) +
+                                             "/1024, but it was expected to be " + std::to_string(_alpha) + "/1024");
+        }
+    }
+};
+
+struct ExpectIssuedFastOpenCookie : public SenderExpectation {
+    std::optional<std::string> _cookie;
+
+    ExpectIssuedFastOpenCookie(std::optional<std::string> cookie) : _cookie(cookie) {}
+    std::string description() const { return "Fast Open cookie " + _cookie.value_or("(none)") + " issued"; }
+
+    void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
+        if (sender.fastopen_cookie() != _cookie) {
+            throw SenderExpectationViolation("The TCPSender reported the wrong Fast Open cookie from the peer");
+        }
+    }
+};
+
+struct ExpectNextDeparture : public SenderExpectation {
+    std::optional<uint64_t> _departure;
+
+    ExpectNextDeparture(std::optional<uint64_t> departure) : _departure(departure) {}
+    std::string description() const {
+        return _departure.has_value() ? "next departure at " + std::to_string(_departure.value()) + " ms"
+                                      : "no paced departure pending";
+    }
+
+    void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
+        if (sender.next_departure() != _departure) {
+            std::string reported =
+                sender.next_departure().has_value() ? std::to_string(sender.next_departure().value()) : "none";
+            std::string expected = _departure.has_value() ? std::to_string(_departure.value()) : "none";
+            throw SenderExpectationViolation("The TCPSender reported next departure `" + reported +
+                                             "`, but it was expected to be `" + expected + "`");
+        }
+    }
+};
+
 struct ExpectNoSegment : public SenderExpectation {
     ExpectNoSegment() {}
     std::string description() const { return "no (more) segments"; }
@@ -191,11 +273,38 @@ struct Tick : public SenderAction {
 struct AckReceived : public SenderAction {
     WrappingInt32 _ackno;
     std::optional<uint16_t> _window_advertisement{};
+    bool _syn_sack_permitted{false};
+    std::optional<uint8_t> _syn_window_scale{};
+    std::optional<uint16_t> _syn_mss{};
+    std::optional<std::string> _syn_fastopen_cookie{};
+    bool _syn{false};
+    bool _ece{false};
+    bool _cwr{false};
+    std::optional<TCPTimestamps> _timestamps{};
+    std::optional<std::vector<TCPSACKBlock>> _sack_blocks{};
 
     AckReceived(WrappingInt32 ackno) : _ackno(ackno) {}
     std::string description() const {
         std::ostringstream ss;
         ss << "ack " << _ackno.raw_value() << " winsize " << _window_advertisement.value_or(DEFAULT_TEST_WINDOW);
+        if (_syn_sack_permitted) {
+            ss << " (SYN with SACK-permitted)";
+        }
+        if (_syn_window_scale.has_value()) {
+            ss << " (SYN with window scale " << +_syn_window_scale.value() << ")";
+        }
+        if (_syn) {
+            ss << " (SYN)";
+        }
+        if (_timestamps.has_value()) {
+            ss << " TSval " << _timestamps.value().tsval << " TSecr " << _timestamps.value().tsecr;
+        }
+        if (_sack_blocks.has_value()) {
+            ss << " sack";
+            for (const auto &block : _sack_blocks.value()) {
+                ss << " " << block.left << "-" << block.right;
+            }
+        }
         return ss.str();
     }
 
@@ -204,8 +313,75 @@ struct AckReceived : public SenderAction {
         return *this;
     }
 
+    //! The ACK is the peer's SYN, and it carries the SACK-permitted option
+    AckReceived &with_syn_sack_permitted() {
+        _syn_sack_permitted = true;
+        return *this;
+    }
+
+    //! The ACK is the peer's SYN, and it carries the window scale option
+    AckReceived &with_syn_window_scale(uint8_t shift) {
+        _syn_window_scale = shift;
+        return *this;
+    }
+
+    AckReceived &with_syn_mss(uint16_t mss) {
+        _syn_mss = mss;
+        return *this;
+    }
+
+    AckReceived &with_syn_fastopen_cookie(const std::string &cookie) {
+        _syn_fastopen_cookie = cookie;
+        return *this;
+    }
+
+    AckReceived &with_ece() {
+        _ece = true;
+        return *this;
+    }
+
+    AckReceived &with_cwr() {
+        _cwr = true;
+        return *this;
+    }
+
+    //! The ACK is the peer's SYN
+    AckReceived &with_syn() {
+        _syn = true;
+        return *this;
+    }
+
+    AckReceived &with_timestamps(uint32_t tsval, uint32_t tsecr) {
+        _timestamps = TCPTimestamps{tsval, tsecr};
+        return *this;
+    }
+
+    AckReceived &with_sack(WrappingInt32 left, WrappingInt32 right) {
+        if (not _sack_blocks.has_value()) {
+            _sack_blocks.emplace();
+        }
+        _sack_blocks.value().push_back({left, right});
+        return *this;
+    }
+
     void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
-        sender.ack_received(_ackno, _window_advertisement.value_or(DEFAULT_TEST_WINDOW));
+        TCPHeader header;
+        header.ack = true;
+        header.ackno = _ackno;
+        header.win = _window_advertisement.value_or(DEFAULT_TEST_WINDOW);
+        header.syn = _syn or _syn_sack_permitted or _syn_window_scale.has_value() or _syn_mss.has_value() or
+                     _syn_fastopen_cookie.has_value();
+        header.mss = _syn_mss;
+        header.fastopen_cookie = _syn_fastopen_cookie;
+        header.ece = _ece;
+        header.cwr = _cwr;
+        header.sack_permitted = _syn_sack_permitted;
+        header.window_scale = _syn_window_scale;
+        header.timestamps = _timestamps;
+        for (const auto &block : _sack_blocks.value_or(std::vector<TCPSACKBlock>{})) {
+            header.sack_blocks.push_back(block);
+        }
+        sender.ack_received(header);
         sender.fill_window();
     }
 };
@@ -220,6 +396,21 @@ struct Close : public SenderAction {
     }
 };
 
+struct Flush : public SenderAction {
+    std::string description() const { return "flush"; }
+
+    void execute(TCPSender &sender, std::queue<TCPSegment> &) const { sender.flush(); }
+};
+
+struct SetCork : public SenderAction {
+    bool _cork;
+
+    SetCork(const bool cork) : _cork(cork) {}
+    std::string description() const { return _cork ? "cork" : "uncork"; }
+
+    void execute(TCPSender &sender, std::queue<TCPSegment> &) const { sender.set_cork(_cork); }
+};
+
 struct ExpectSegment : public SenderExpectation {
     std::optional<bool> ack{};
     std::optional<bool> rst{};
@@ -230,6 +421,15 @@ struct ExpectSegment : public SenderExpectation {
     std::optional<uint16_t> win{};
     std::optional<size_t> payload_size{};
     std::optional<std::string> data{};
+    std::optional<bool> sack_permitted{};
+    std::optional<bool> psh{};
+    std::optional<std::optional<uint8_t>> window_scale{};
+    std::optional<std::optional<uint16_t>> mss{};
+    std::optional<std::optional<std::string>> fastopen_cookie{};
+    std::optional<bool> ece{};
+    std::optional<bool> cwr{};
+    std::optional<bool> ect{};
+    std::optional<std::optional<uint32_t>> tsval{};
 
     ExpectSegment &with_ack(bool ack_) {
         ack = ack_;
@@ -288,6 +488,52 @@ struct ExpectSegment : public SenderExpectation {
         return *this;
     }
 
+    ExpectSegment &with_sack_permitted(bool sack_permitted_) {
+        sack_permitted = sack_permitted_;
+        return *this;
+    }
+
+    ExpectSegment &with_psh(bool psh_) {
+        psh = psh_;
+        return *this;
+    }
+
+    ExpectSegment &with_window_scale(std::optional<uint8_t> window_scale_) {
+        window_scale = window_scale_;
+        return *this;
+    }
+
+    ExpectSegment &with_mss(std::optional<uint16_t> mss_) {
+        mss = mss_;
+        return *this;
+    }
+
+    ExpectSegment &with_ece(bool ece_) {
+        ece = ece_;
+        return *this;
+    }
+
+    ExpectSegment &with_cwr(bool cwr_) {
+        cwr = cwr_;
+        return *this;
+    }
+
+    ExpectSegment &with_ect(bool ect_) {
+        ect = ect_;
+        return *this;
+    }
+
+    ExpectSegment &with_fastopen_cookie(std::optional<std::string> fastopen_cookie_) {
+        fastopen_cookie = fastopen_cookie_;
+        return *this;
+    }
+
+    //! The segment carries the timestamps option with this TSval (or, if empty, no timestamps option)
+    ExpectSegment &with_tsval(std::optional<uint32_t> tsval_) {
+        tsval = tsval_;
+        return *this;
+    }
+
     std::string segment_description() const {
         std::ostringstream o;
         o << "(";
@@ -303,6 +549,22 @@ struct ExpectSegment : public SenderExpectation {
         if (fin.has_value()) {
             o << (fin.value() ? "F=1," : "F=0,");
         }
+        if (psh.has_value()) {
+            o << (psh.value() ? "P=1," : "P=0,");
+        }
+        if (sack_permitted.has_value()) {
+            o << (sack_permitted.value() ? "SACK-permitted," : "no SACK-permitted,");
+        }
+        if (window_scale.has_value()) {
+            o << (window_scale.value().has_value() ? "wscale=" + std::to_string(window_scale.value().value())
+                                                   : std::string("no wscale"))
+              << ",";
+        }
+        if (tsval.has_value()) {
+            o << (tsval.value().has_value() ? "TSval=" + std::to_string(tsval.value().value())
+                                            : std::string("no timestamps"))
+              << ",";
+        }
         if (ackno.has_value()) {
             o << "ackno=" << ackno.value() << ",";
         }
@@ -336,12 +598,19 @@ struct ExpectSegment : public SenderExpectation {
 
     virtual std::string description() const { return "segment sent with " + segment_description(); }
 
-    void execute(TCPSender &, std::queue<TCPSegment> &segments) const {
+    void execute(TCPSender &sender, std::queue<TCPSegment> &segments) const {
         if (segments.empty()) {
             throw SegmentExpectationViolation::violated_verb("existed");
         }
         TCPSegment seg = std::move(segments.front());
         segments.pop();
+        // The checksum must hold whether the payload was summed when serialized or while it was copied
+        for (size_t i = 0; i < seg.wire_segment_count(); i++) {
+            TCPSegment wire;
+            if (wire.parse(Buffer{seg.serialize(0, i).concatenate()}) != ParseResult::NoError) {
+                throw SegmentExpectationViolation("The TCPSender's segment does not serialize with a good checksum");
+            }
+        }
         if (ack.has_value() and seg.header().ack != ack.value()) {
             throw SegmentExpectationViolation::violated_field("ack", ack.value(), seg.header().ack);
         }
@@ -354,6 +623,38 @@ struct ExpectSegment : public SenderExpectation {
         if (fin.has_value() and seg.header().fin != fin.value()) {
             throw SegmentExpectationViolation::violated_field("fin", fin.value(), seg.header().fin);
         }
+        if (ece.has_value() and seg.header().ece != ece.value()) {
+            throw SegmentExpectationViolation::violated_field("ece", ece.value(), seg.header().ece);
+        }
+        if (cwr.has_value() and seg.header().cwr != cwr.value()) {
+            throw SegmentExpectationViolation::violated_field("cwr", cwr.value(), seg.header().cwr);
+        }
+        if (ect.has_value() and seg.ect() != ect.value()) {
+            throw SegmentExpectationViolation::violated_field("ect", ect.value(), seg.ect());
+        }
+        if (fastopen_cookie.has_value() and seg.header().fastopen_cookie != fastopen_cookie.value()) {
+            throw SegmentExpectationViolation("The TCPSender's segment had the wrong Fast Open cookie");
+        }
+        if (mss.has_value() and seg.header().mss != mss.value()) {
+            throw SegmentExpectationViolation("The TCPSender's segment had the wrong MSS option");
+        }
+        if (window_scale.has_value() and seg.header().window_scale != window_scale.value()) {
+            throw SegmentExpectationViolation("The TCPSender's segment had the wrong window scale option");
+        }
+        if (tsval.has_value()) {
+            const auto &timestamps = seg.header().timestamps;
+            if (timestamps.has_value() != tsval.value().has_value() or
+                (timestamps.has_value() and timestamps.value().tsval != tsval.value().value())) {
+                throw SegmentExpectationViolation("The TCPSender's segment had the wrong timestamps option");
+            }
+        }
+        if (psh.has_value() and seg.header().psh != psh.value()) {
+            throw SegmentExpectationViolation::violated_field("psh", psh.value(), seg.header().psh);
+        }
+        if (sack_permitted.has_value() and seg.header().sack_permitted != sack_permitted.value()) {
+            throw SegmentExpectationViolation::violated_field(
+                "sack_permitted", sack_permitted.value(), seg.header().sack_permitted);
+        }
         if (seqno.has_value() and seg.header().seqno != seqno.value()) {
             throw SegmentExpectationViolation::violated_field("seqno", seqno.value(), seg.header().seqno);
         }
@@ -367,7 +668,8 @@ struct ExpectSegment : public SenderExpectation {
             throw SegmentExpectationViolation::violated_field(
                 "payload_size", payload_size.value(), seg.payload().size());
         }
-        if (seg.payload().size() > TCPConfig::MAX_PAYLOAD_SIZE) {
+        const size_t max_payload_size = std::max(sender.mss(), sender.mtu_probe_size().value_or(0));
+        if (seg.payload().size() > std::max(TCPConfig::MAX_PAYLOAD_SIZE, max_payload_size)) {
             throw SegmentExpectationViolation("packet has length (" + std::to_string(seg.payload().size()) +
                                               ") greater than the maximum");
         }
@@ -392,16 +694,19 @@ class TCPSenderTestHarness {
     }
 
   public:
-    TCPSenderTestHarness(const std::string &name_, TCPConfig config)
+    //! \param initial_data is written before the first fill_window(), so that Fast Open can put it on the SYN
+    TCPSenderTestHarness(const std::string &name_, TCPConfig config, const std::string &initial_data = {})
         : outbound_segments()
-        , sender(config.send_capacity, config.rt_timeout, config.fixed_isn)
+        , sender(config)
         , steps_executed()
         , name(name_) {
+        sender.stream_in().write(initial_data);
         sender.fill_window();
         collect_output();
         std::ostringstream ss;
         ss << "Initialized with ("
-           << "retx-timeout=" << config.rt_timeout << ") and called fill_window()";
+           << "retx-timeout=" << config.rt_timeout << "), wrote " << initial_data.size()
+           << " bytes and called fill_window()";
         steps_executed.emplace_back(ss.str());
     }
 
@@ -0,0 +1,163 @@
+#include "parser.hh"
+#include "tcp_header.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static size_t allocations = 0;
+
+void *operator new(size_t size) {
+    allocations++;
+    void *ptr = malloc(size ? size : 1);
+    if (not ptr) {
+        throw bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept { free(ptr); }
+
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+
+//! A header with an ACK and the given option bytes, which must be a multiple of four long
+static string header_with_options(const string &options) {
+    string header(TCPHeader::LENGTH, '\0');
+    header[12] = static_cast<char>((TCPHeader::LENGTH + options.size()) / 4 << 4);
+    header[13] = 0x10;
+    return header + options;
+}
+
+static TCPHeader parse(const string &bytes) {
+    TCPHeader header;
+    NetParser p{string{bytes}};
+    if (const auto res = header.parse(p); res != ParseResult::NoError) {
+        throw runtime_error("header did not parse: " + as_string(res));
+    }
+    return header;
+}
+
+//! The options as serialize() writes them
+static string serialized_options(const TCPHeader &header) { return header.serialize().substr(TCPHeader::LENGTH); }
+
+int main() {
+    try {
+        {
+            // What Linux puts on a SYN: MSS, SACK-permitted sharing a word with the timestamps, then window scale
+            const string options{"\x02\x04\x05\xb4\x04\x02\x08\x0a\x00\x01\x02\x03\x00\x00\x00\x00\x01\x03\x03\x07",
+                                 20};
+            const TCPHeader header = parse(header_with_options(options));
+            if (header.mss != 1460 or not header.sack_permitted or header.window_scale != 7 or
+                not(header.timestamps == TCPTimestamps{0x00010203, 0})) {
+                throw runtime_error("SYN options parsed wrong:\n" + header.to_string());
+            }
+            if (serialized_options(header) != options) {
+                throw runtime_error("SYN options did not serialize as they arrived");
+            }
+        }
+
+        {
+            // Timestamps alone (the fast path), and with a SACK block, each aligned by NOPs
+            const string timestamps{"\x01\x01\x08\x0a\xde\xad\xbe\xef\x00\x00\x00\x2a", 12};
+            const TCPHeader header = parse(header_with_options(timestamps));
+            if (not(header.timestamps == TCPTimestamps{0xdeadbeef, 42}) or header.mss.has_value() or
+                serialized_options(header) != timestamps) {
+                throw runtime_error("timestamps option did not round-trip:\n" + header.to_string());
+            }
+
+            const string with_sack = timestamps + string{"\x01\x01\x05\x0a\x00\x00\x03\xe8\x00\x00\x04\x1a", 12};
+            const TCPHeader sack = parse(header_with_options(with_sack));
+            if (sack.sack_blocks.size() != 1 or sack.sack_blocks[0].left != WrappingInt32{1000} or
+                sack.sack_blocks[0].right != WrappingInt32{1050} or serialized_options(sack) != with_sack) {
+                throw runtime_error("timestamps and SACK options did not round-trip:\n" + sack.to_string());
+            }
+        }
+
+        {
+            // Options not understood are kept in order and sent again after the others, padded with NOPs
+            const string unknown{"\x1c\x04\x80\x10\xfe\x06\xf9\x89\xaa\xbb", 10};
+            const string options = string{"\x02\x04\x05\xb4", 4} + unknown + string{"\x00\x00", 2};
+            const TCPHeader header = parse(header_with_options(options));
+            if (header.mss != 1460 or header.unknown_options.size() != unknown.size() or
+                string(header.unknown_options.begin(), header.unknown_options.end()) != unknown) {
+                throw runtime_error("unknown options were not kept:\n" + header.to_string());
+            }
+            if (serialized_options(header) != string{"\x02\x04\x05\xb4", 4} + unknown + "\x01\x01") {
+                throw runtime_error("unknown options were not sent again");
+            }
+            if (not(parse(header.serialize()) == header)) {
+                throw runtime_error("unknown options did not round-trip");
+            }
+
+            // One too long to keep (an MD5 signature) is dropped, and the options after it are still read
+            const string md5 = string{"\x13\x12"} + string(16, '\x55');
+            const TCPHeader dropped = parse(header_with_options(md5 + "\x01\x01\x01\x03\x03\x07"));
+            if (not dropped.unknown_options.empty() or dropped.window_scale != 7) {
+                throw runtime_error("an unknown option too long to keep was mishandled:\n" + dropped.to_string());
+            }
+        }
+
+        {
+            // A malformed length ends option processing, but not the parse
+            const TCPHeader header = parse(header_with_options(string{"\x02\x04\x05\xb4\x03\xff\x00\x00", 8}));
+            if (header.mss != 1460 or header.window_scale.has_value() or not header.unknown_options.empty()) {
+                throw runtime_error("a malformed option was not ignored:\n" + header.to_string());
+            }
+        }
+
+        {
+            // Each option starts on a four-byte boundary, so its multi-byte fields are aligned
+            TCPHeader header;
+            header.syn = true;
+            header.mss = 1460;
+            header.sack_permitted = true;
+            header.window_scale = 7;
+            header.fastopen_cookie = string{"abcde"};
+            header.doff = (TCPHeader::LENGTH + header.options_length()) / 4;
+            const string options = serialized_options(header);
+            if (options.size() != header.options_length() or options.size() % 4 != 0 or
+                options != string{"\x02\x04\x05\xb4\x04\x02\x01\x01\x01\x03\x03\x07\x22\x07"} + "abcde" + "\x01") {
+                throw runtime_error("options were not aligned with NOPs");
+            }
+            if (not(parse(header.serialize()) == header)) {
+                throw runtime_error("a SYN with a Fast Open cookie did not round-trip");
+            }
+        }
+
+        {
+            // Parsing and copying a header with each variable-length kind of option do not allocate
+            TCPHeader header;
+            header.timestamps = TCPTimestamps{1, 2};
+            header.fastopen_cookie = string{"abcdefgh"};
+            header.sack_blocks.push_back({WrappingInt32{1000}, WrappingInt32{1050}});
+            header.unknown_options.push_back(0x1c);
+            header.unknown_options.push_back(4);
+            header.unknown_options.push_back(0x80);
+            header.unknown_options.push_back(0x10);
+            header.doff = (TCPHeader::LENGTH + header.options_length()) / 4;
+            NetParser p{header.serialize()};
+
+            const size_t before = allocations;
+            TCPHeader parsed;
+            const ParseResult res = parsed.parse(p);
+            const TCPHeader copy = parsed;
+            if (allocations != before) {
+                throw runtime_error("parsing or copying a header allocated");
+            }
+            if (res != ParseResult::NoError or not(copy == header)) {
+                throw runtime_error("a header with every option did not round-trip:\n" + copy.to_string());
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
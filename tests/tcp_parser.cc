@@ -118,6 +118,44 @@ int main(int argc, char **argv) {
             }
         }
 
+        // options that fill the header as sent can need more room once they are aligned again: a 4-block SACK and
+        // a 5-byte unknown option are 39 bytes, but 36 + 8 when serialized, so the unknown option is not kept
+        {
+            string sack{"\x05\x22", 2};
+            for (unsigned i = 0; i < 8; ++i) {
+                const uint32_t edge = 1000 * (i + 1);
+                sack += string{static_cast<char>(edge >> 24), static_cast<char>(edge >> 16),
+                               static_cast<char>(edge >> 8), static_cast<char>(edge)};
+            }
+            const string unknown{"\xfd\x05\xaa\xbb\xcc", 5};
+            for (const auto &options : {sack + unknown + '\0', unknown + sack + '\0'}) {
+                vector<uint8_t> test_header(20, 0);
+                test_header[12] = 0xf0;  // doff = 15
+                test_header[13] = 0x10;  // ACK
+                test_header.insert(test_header.end(), options.begin(), options.end());
+                const auto checksum = inet_cksum(test_header.data(), test_header.size());
+                test_header[16] = checksum >> 8;
+                test_header[17] = checksum & 0xff;
+
+                TCPSegment seg;
+                if (const auto res = seg.parse(string(test_header.begin(), test_header.end()));
+                    res != ParseResult::NoError) {
+                    throw runtime_error("full option space: parse failed: " + as_string(res));
+                }
+                if (seg.header().sack_blocks.size() != 4) {
+                    throw runtime_error("full option space: SACK blocks were not kept");
+                }
+                seg.header().doff = 5;
+                TCPSegment reparsed;
+                if (const auto res = reparsed.parse(seg.serialize().concatenate()); res != ParseResult::NoError) {
+                    throw runtime_error("full option space: re-parse failed: " + as_string(res));
+                }
+                if (not compare_tcp_options(seg.header(), reparsed.header())) {
+                    throw runtime_error("full option space: options did not round-trip");
+                }
+            }
+        }
+
         // now process some segments off the wire for correctness of parser and unparser
         if (argc < 2) {
             cout << "USAGE: " << argv[0] << " <filename>" << endl;
@@ -196,7 +234,8 @@ int main(int argc, char **argv) {
                 auto &tcp_hdr_orig = tcp_seg.header();
                 TCPHeader &tcp_hdr_copy = tcp_seg_copy.header();
                 tcp_hdr_copy = tcp_hdr_orig;
-                // fix up segment to remove IPv4 and TCP header extensions
+                // fix up segment to remove IPv4 and TCP header extensions; the options are kept, and the data
+                // offset written is what they need
                 tcp_hdr_copy.doff = 5;
             }  // tcp_hdr_{orig,copy} go out of scope
 
@@ -220,11 +259,24 @@ int main(int argc, char **argv) {
                 ok = false;
                 continue;
             }
-            if (!compare_tcp_headers(tcp_seg_copy.header(), tcp_seg_copy2.header())) {
+            if (!compare_tcp_headers_nolen(tcp_seg_copy.header(), tcp_seg_copy2.header()) or
+                tcp_seg_copy2.header().doff != (TCPHeader::LENGTH + tcp_seg_copy.header().options_length()) / 4) {
                 cout << "ERROR: after re-parsing, TCP headers don't match.\n";
                 ok = false;
                 continue;
             }
+            if (!compare_tcp_options(tcp_seg.header(), tcp_seg_copy2.header())) {
+                cout << "ERROR: after re-parsing, TCP options don't match.\n";
+                cout << "original:\n" << tcp_seg.header().to_string() << "re-parsed:\n"
+                     << tcp_seg_copy2.header().to_string();
+                ok = false;
+                continue;
+            }
+            if (tcp_seg_copy2.serialize().concatenate() != tcp_seg_copy.serialize().concatenate()) {
+                cout << "ERROR: a re-parsed segment does not serialize as it did.\n";
+                ok = false;
+                continue;
+            }
             if (tcp_seg_copy.payload().str() != tcp_seg_copy2.payload().str()) {
                 cout << "ERROR: after re-parsing, TCP payloads don't match.\n";
                 ok = false;
@@ -39,4 +39,10 @@ inline bool compare_tcp_headers(const TCPHeader &h1, const TCPHeader &h2) {
     return compare_tcp_headers_nolen(h1, h2) && h1.doff == h2.doff;
 }
 
+inline bool compare_tcp_options(const TCPHeader &h1, const TCPHeader &h2) {
+    return h1.mss == h2.mss && h1.sack_permitted == h2.sack_permitted && h1.window_scale == h2.window_scale &&
+           h1.timestamps == h2.timestamps && h1.sack_blocks == h2.sack_blocks &&
+           h1.fastopen_cookie == h2.fastopen_cookie && h1.unknown_options == h2.unknown_options;
+}
+
 #endif  // SPONGE_TESTS_TEST_UTILS_HH